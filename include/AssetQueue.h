@@ -0,0 +1,64 @@
+#ifndef ASSETQUEUE_H
+#define ASSETQUEUE_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "JobSystem.h"
+
+// Carregamento assíncrono de assets em duas partes:
+//
+//   - a carga (Load) roda em uma thread de trabalho do JobSystem: lê
+//     arquivos, decodifica imagens, processa malhas... tudo que não precisa
+//     de OpenGL. Ela termina deixando em "uploads" o que falta fazer;
+//   - os envios (Upload) rodam na thread do OpenGL, em update(), que é
+//     chamada a cada quadro com um limite de tempo: os buffers e texturas
+//     vão chegando aos poucos e a janela continua respondendo.
+//
+// Os dados de uma carga para os seus envios vão capturados nos próprios
+// envios (p.ex. em um std::shared_ptr). Os envios de uma carga rodam na
+// ordem em que ela os deixou; cargas diferentes são enviadas na ordem em
+// que terminam.
+//
+// load(), update() e as consultas são da thread do OpenGL. O JobSystem
+// precisa de pelo menos duas threads para que as cargas não rodem dentro
+// de load() (veja JobSystem::run()).
+class AssetQueue
+{
+    public:
+        typedef std::function<void()> Upload;
+        typedef std::function<void(std::vector<Upload>& uploads)> Load;
+
+        AssetQueue(JobSystem& jobs);
+        AssetQueue(const AssetQueue&) = delete;
+        AssetQueue& operator=(const AssetQueue&) = delete;
+        // Espera as cargas em andamento; envios pendentes são descartados
+        virtual ~AssetQueue();
+
+        void load(const Load& load);
+
+        // Executa envios prontos até passar de "budget" segundos (um envio
+        // começado sempre termina). Retorna quantos foram executados.
+        unsigned int update(double budget);
+
+        size_t total() const { return requested; }   // cargas pedidas
+        size_t loaded() const { return completed; }  // cargas com todos os envios feitos
+        bool done() const { return completed == requested; }
+
+    protected:
+
+    private:
+        JobSystem& jobs;
+        JobCounter counter;
+
+        std::mutex mutex;
+        std::deque<std::vector<Upload> > ready; // envios de cada carga terminada
+        size_t next; // próximo envio de ready.front()
+
+        size_t requested;
+        size_t completed;
+};
+
+#endif // ASSETQUEUE_H
@@ -2,11 +2,12 @@
 #define ASTEROID_H
 
 #include <math.h>
-#include <vector>
 #include <iostream>
 #include <glm/vec4.hpp>
 #include <glm/vec3.hpp>
 
+#include "Trajectory.h"
+
 class Asteroid
 {
     public:
@@ -15,16 +16,14 @@ class Asteroid
         float velocity;
         float scale;
 
-        // for bezier
-        std::vector<glm::vec4> controlPoints;
+        // curva de bezier, já convertida para a base de potências
+        Trajectory trajectory;
         float t;
 
         Asteroid();
-        Asteroid(glm::vec4 pos, std::vector<glm::vec4> control);
+        Asteroid(glm::vec4 pos, const Trajectory& trajectory);
         virtual ~Asteroid();
 
-        void computeNewPosition(float deltaTime);
-
     protected:
 
     private:
@@ -0,0 +1,85 @@
+#ifndef ASTEROIDFIELD_H
+#define ASTEROIDFIELD_H
+
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "Asteroid.h"
+#include "SlotMap.h"
+
+// Armazena todos os asteroides como "structure of arrays": cada atributo fica
+// em um vetor contíguo de floats, de forma que a atualização de posições
+// percorre a memória sequencialmente e pode avaliar 4 (SSE) ou 8 (AVX)
+// asteroides por instrução. Cada asteroide também tem um EntityHandle
+// estável; a remoção é adiada (destroyLater) e aplicada com swap-and-pop em
+// flush(), no fim do tick.
+class AsteroidField
+{
+    public:
+        // posição atual
+        std::vector<float> px, py, pz;
+        // parâmetro da curva, velocidade (dt/t), escala e rotação
+        std::vector<float> t, velocity, scale;
+        std::vector<float> rx, ry, rz;
+        // coeficientes da trajetória P(t) = a*t^3 + b*t^2 + c*t + d
+        std::vector<float> ax, ay, az;
+        std::vector<float> bx, by, bz;
+        std::vector<float> cx, cy, cz;
+        std::vector<float> dx, dy, dz;
+
+        AsteroidField();
+        AsteroidField(const AsteroidField&) = delete; // columns[] aponta para os próprios membros
+        AsteroidField& operator=(const AsteroidField&) = delete;
+        virtual ~AsteroidField();
+
+        size_t size() const { return t.size(); }
+        bool empty() const { return t.empty(); }
+
+        EntityHandle add(const Asteroid& asteroid);
+        void clear();
+
+        bool valid(EntityHandle handle) const { return handles.valid(handle); }
+        size_t indexOf(EntityHandle handle) const { return handles.indexOf(handle); }
+        EntityHandle handleAt(size_t i) const { return handles.handleAt(i); }
+
+        bool destroyLater(size_t i) { return handles.destroyLater(handles.handleAt(i)); }
+        bool destroyLater(EntityHandle handle) { return handles.destroyLater(handle); }
+        bool isDying(size_t i) const { return handles.isDying(i); }
+        // Remove os asteroides marcados; o último asteroide ocupa cada buraco
+        void flush();
+        void reserve(size_t n);
+
+        glm::vec4 position(size_t i) const { return glm::vec4(px[i], py[i], pz[i], 1.0f); }
+        glm::vec3 rotation(size_t i) const { return glm::vec3(rx[i], ry[i], rz[i]); }
+        Trajectory trajectory(size_t i) const;
+
+        // Velocidade (unidades/segundo) do asteroide i no instante atual
+        glm::vec4 linearVelocity(size_t i) const;
+        // Posição prevista daqui a deltaTime segundos (negativo: no passado)
+        glm::vec4 predictPosition(size_t i, float deltaTime) const;
+        // AABB do centro do asteroide i entre agora e daqui a deltaTime
+        // segundos. Com deltaTime negativo, o trecho que acabou de percorrer.
+        void sweptBounds(size_t i, float deltaTime, glm::vec3& bbox_min, glm::vec3& bbox_max) const;
+
+        // Avança t e recalcula a posição de todos os asteroides
+        void computeNewPositions(float deltaTime);
+        // Só dos asteroides [begin, end); intervalos disjuntos podem ser
+        // calculados em paralelo
+        void computeNewPositions(float deltaTime, size_t begin, size_t end);
+
+    protected:
+
+    private:
+        static const int NUM_COLUMNS = 21;
+        std::vector<float>* columns[NUM_COLUMNS];
+        HandleTable handles;
+
+        void remove(size_t i); // swap-and-pop: o último asteroide ocupa a posição i
+
+        void computeNewPositionsScalar(size_t begin, size_t end, float deltaTime);
+        size_t computeNewPositionsSSE(size_t begin, size_t end, float deltaTime);
+        size_t computeNewPositionsAVX(size_t begin, size_t end, float deltaTime);
+};
+
+#endif // ASTEROIDFIELD_H
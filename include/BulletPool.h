@@ -0,0 +1,47 @@
+#ifndef BULLETPOOL_H
+#define BULLETPOOL_H
+
+#include <vector>
+#include <glm/vec4.hpp>
+
+#include "bullet.h"
+
+// Tiros em um buffer circular de capacidade fixa, em ordem de disparo. Como
+// todo tiro anda em linha reta com a mesma velocidade, o instante em que ele
+// sai do alcance é conhecido no disparo e os tiros expiram na mesma ordem em
+// que foram disparados: retire() só precisa olhar o mais antigo. Nada é
+// alocado depois da construção e as posições são calculadas sob demanda
+// (bullet::position).
+class BulletPool
+{
+    public:
+        float range; // distância, a partir do ponto de disparo, em que o tiro some
+
+        BulletPool(size_t capacity, float range);
+        virtual ~BulletPool();
+
+        // Dispara no instante "time". Com o buffer cheio, o tiro mais antigo
+        // é descartado.
+        void add(const bullet& b, float time);
+        // Descarta os tiros que já saíram do alcance no instante "time"
+        void retire(float time);
+        void clear();
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        size_t capacity() const { return items.size(); }
+
+        // i = 0 é o tiro mais antigo ainda vivo
+        const bullet& operator[](size_t i) const { return items[(tail + i) & mask]; }
+        glm::vec4 position(size_t i, float time) const { return (*this)[i].position(time); }
+
+    protected:
+
+    private:
+        std::vector<bullet> items; // tamanho potência de 2
+        size_t mask;
+        size_t tail;  // tiro mais antigo
+        size_t count;
+};
+
+#endif // BULLETPOOL_H
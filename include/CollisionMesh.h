@@ -0,0 +1,51 @@
+#ifndef COLLISIONMESH_H
+#define COLLISIONMESH_H
+
+#include <stdint.h>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+// Malha de triângulos estática para testes de colisão exatos, no espaço do
+// modelo. Construída uma única vez no carregamento: os vértices repetidos
+// são unidos e os triângulos organizados em uma BVH (hierarquia de AABBs),
+// de modo que intersectsSphere() só visita os triângulos próximos da esfera
+// e não aloca memória.
+class CollisionMesh
+{
+    public:
+        CollisionMesh();
+        virtual ~CollisionMesh();
+
+        // "triangles" tem três vértices por triângulo (como em
+        // CollectModelVertices()); w é ignorado
+        void build(const std::vector<glm::vec4>& triangles);
+
+        bool empty() const { return indices.empty(); }
+        size_t vertexCount() const { return positions.size(); }
+        size_t triangleCount() const { return indices.size() / 3; }
+        float boundingRadius() const { return radius; } // em torno da origem do modelo
+
+        // Teste esfera-triângulo exato, com a esfera no espaço do modelo
+        bool intersectsSphere(glm::vec3 center, float sphere_radius) const;
+
+    protected:
+
+    private:
+        struct Node
+        {
+            glm::vec3 bbox_min;
+            glm::vec3 bbox_max;
+            uint32_t first; // folha: primeiro triângulo; interno: filho da direita (o da esquerda é o próximo nó)
+            uint32_t count; // número de triângulos; 0 para nós internos
+        };
+
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices; // 3 por triângulo, na ordem das folhas
+        std::vector<Node> nodes;
+        float radius;
+
+        uint32_t buildNode(std::vector<uint32_t>& order, std::vector<glm::vec3>& centroids, uint32_t begin, uint32_t end, int depth);
+};
+
+#endif // COLLISIONMESH_H
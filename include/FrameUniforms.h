@@ -0,0 +1,44 @@
+#ifndef FRAMEUNIFORMS_H
+#define FRAMEUNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+// Ponto de ligação do bloco "FrameUniforms" dos shaders
+#define FRAME_UNIFORMS_BINDING 0
+
+// Dados da câmera e da luz, iguais para todos os programas durante um
+// quadro. O layout é o std140 do bloco "FrameUniforms" em
+// "shader_vertex.glsl", "shader_fragment.glsl" e "skybox.vs": só mat4 e
+// vec4, que em std140 ocupam exatamente o que ocupam na glm.
+struct FrameUniformData
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 view_projection;
+    glm::vec4 camera_position; // no mundo, w = 1
+    glm::vec4 light_direction; // sentido para a luz, no mundo, w = 0
+};
+
+// Um uniform buffer object com os FrameUniformData, ligado uma única vez
+// ao ponto FRAME_UNIFORMS_BINDING. Cada programa que usa o bloco é
+// associado ao ponto com attach(); depois disso basta um update() por
+// quadro, em vez de um glUniform por matriz por programa.
+class FrameUniforms
+{
+    public:
+        FrameUniforms();
+        virtual ~FrameUniforms();
+
+        // Associa o bloco "FrameUniforms" de um programa ao ponto de ligação
+        void attach(GLuint program) const;
+        void update(const FrameUniformData& data);
+
+    protected:
+
+    private:
+        GLuint buffer_id;
+};
+
+#endif // FRAMEUNIFORMS_H
@@ -0,0 +1,40 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+// Os seis planos do volume de visão, extraídos da matriz projection * view
+// (método de Gribb e Hartmann). Cada plano é (nx, ny, nz, d) com a normal
+// unitária apontando para dentro: um ponto p está do lado de dentro se
+// dot(n, p) + d >= 0.
+class Frustum
+{
+    public:
+        // esquerda, direita, baixo, cima, perto, longe
+        static const int NUM_PLANES = 6;
+        glm::vec4 planes[NUM_PLANES];
+
+        Frustum();
+        // clip = projection * view; objetos em coordenadas do mundo
+        explicit Frustum(const glm::mat4& clip);
+
+        void extract(const glm::mat4& clip);
+
+        bool intersectsSphere(glm::vec3 center, float radius) const;
+
+        // Testa em lote as esferas i = 0..n-1 de centro (x[i], y[i], z[i]) e
+        // raio radius[i] * radius_scale, 4 (SSE) ou 8 (AVX) por vez.
+        // visible[i] recebe 1 se a esfera toca o volume de visão e 0 se está
+        // inteira do lado de fora de algum plano. Retorna quantas são
+        // visíveis. O teste é conservador: esferas perto de um canto do
+        // volume podem ser dadas como visíveis sem estar.
+        size_t cullSpheres(const float* x, const float* y, const float* z,
+                           const float* radius, float radius_scale,
+                           size_t n, uint8_t* visible) const;
+};
+
+#endif // FRUSTUM_H
@@ -0,0 +1,130 @@
+#ifndef GAMEWORLD_H
+#define GAMEWORLD_H
+
+#include <vector>
+#include <random>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "Spaceship.h"
+#include "Asteroid.h"
+#include "AsteroidField.h"
+#include "Player.h"
+#include "bullet.h"
+#include "BulletPool.h"
+#include "SpatialHash.h"
+#include "CollisionMesh.h"
+#include "RaySphere.h"
+#include "JobSystem.h"
+
+/// Configurations
+#define MAX_ASTEROIDS 35
+#define ASTEROIDS_SPAWN_DISTANCE 20 // distance relative to spaceship
+#define ASTEROIDS_DESTROY_DISTANCE 25 // distance relative to spaceship
+#define SIMULATION_TIMESTEP (1.0f / 60.0f) // passo fixo da simulação (segundos)
+#define BROADPHASE_CELL_SIZE 2.0f // aresta da célula da grade de colisão (~ diâmetro de um asteroide)
+#define BULLET_POOL_CAPACITY 256 // tiros vivos ao mesmo tempo (~ 5x o máximo atirando a cada tick)
+#define BULLET_BATCH_MAX_PAIRS 16384 // até quantos pares tiro-asteroide testar todos contra todos, sem a grade
+#define JOB_ASTEROIDS_PER_TASK 1024 // asteroides por job na atualização de posições (múltiplo de 8)
+#define JOB_PAIRS_PER_TASK 512 // pares asteroide-asteroide por job na narrowphase
+#define JOB_BULLETS_PER_TASK 8 // tiros por job na narrowphase
+
+// Estado dos controles da nave em um tick da simulação. Preenchido pelos
+// callbacks da GLFW no modo com janela, ou por um piloto automático no modo
+// headless.
+struct GameInput
+{
+    bool left  = false;
+    bool right = false;
+    bool up    = false;
+    bool down  = false;
+    bool shoot = false; // consumido pelo próximo step()
+};
+
+// Contadores acumulados da detecção de colisão: quantos pares a broadphase
+// entregou para o teste exato e quantos desses realmente colidiram.
+struct CollisionStats
+{
+    unsigned long spaceshipCandidates = 0;
+    unsigned long spaceshipHits       = 0;
+    unsigned long asteroidCandidates  = 0; // pares asteroide-asteroide
+    unsigned long asteroidHits        = 0;
+    unsigned long bulletCandidates    = 0; // pares asteroide-tiro
+    unsigned long bulletHits          = 0;
+};
+
+// Toda a lógica do jogo (nave, asteroides, tiros, colisões e pontuação),
+// sem nenhuma dependência de GLFW ou OpenGL. Avança no tempo via step(dt).
+// As partes pesadas do tick rodam em paralelo no JobSystem, mas cada job só
+// escreve na sua parte dos resultados e tudo que altera o estado do jogo é
+// aplicado em ordem de índice: o resultado não depende do número de threads.
+class GameWorld
+{
+    public:
+        Player player;
+        Spaceship spaceship;
+        AsteroidField asteroids;
+        BulletPool bullets;
+        size_t maxAsteroids = MAX_ASTEROIDS;
+
+        GameInput input;
+        glm::mat4 spaceshipModel; // matriz "model" da nave no último tick
+        glm::mat4 spaceshipInverseModel; // mundo -> espaço do modelo da nave
+        float time = 0.0f;        // tempo simulado (segundos)
+        unsigned long ticks = 0;
+        CollisionStats collisionStats;
+
+        // threads = 0 usa uma thread por núcleo (veja JobSystem)
+        GameWorld(unsigned int seed, unsigned int threads = 0);
+        virtual ~GameWorld();
+
+        // Triângulos (espaço do modelo, três vértices cada) usados no teste de
+        // colisão com a nave
+        void setSpaceshipMesh(const std::vector<glm::vec4>& triangles);
+
+        void step(float deltaTime);
+        bool isGameOver();
+        unsigned int threadCount() const { return jobs.threadCount(); }
+
+    protected:
+
+    private:
+        JobSystem jobs;
+        std::mt19937 rng;
+        CollisionMesh spaceshipMesh;
+
+        // broadphase, reconstruída a cada tick, e buffers reaproveitados entre ticks
+        SpatialHash grid;
+        std::vector<std::pair<uint32_t, uint32_t> > candidatePairs;
+        std::vector<uint32_t> candidates;
+        SpherePack asteroidSpheres;
+        RayPack bulletRays;
+        std::vector<unsigned char> farAsteroid, pairHit;
+        std::vector<unsigned char> hitSpaceship, hitAsteroid, hitBullet;
+        std::vector<glm::vec3> previousPosition; // centro de cada asteroide no tick anterior
+
+        // saída de cada job de testBullets(), juntada em ordem no fim
+        struct BulletTask
+        {
+            std::vector<uint32_t> candidates;
+            SpherePack spheres;
+            std::vector<RayHit> hits;
+            unsigned long tested;
+        };
+        std::vector<BulletTask> bulletTasks;
+
+        float randomFloat(float min, float max);
+        Asteroid generateNewAsteroid();
+        void removeFarObjects();
+        void testCollisions(float deltaTime);
+        void testSpaceship();
+        void testAsteroidPairs();
+        void testBullets(float now); // todos os tiros contra os asteroides, em lote (veja RaySphere.h)
+
+        // testes de colisão do asteroide de índice i em "asteroids"
+        bool testInterseption(size_t asteroid, const Spaceship& spaceship, const glm::mat4& inverse_model);
+        bool testInterseption(size_t asteroid1, size_t asteroid2);
+};
+
+#endif // GAMEWORLD_H
@@ -0,0 +1,88 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Contador de dependências: cada job enviado com run() incrementa, e
+// decrementa quando termina. Quem depende de um grupo de jobs espera o
+// contador chegar a zero com JobSystem::wait().
+struct JobCounter
+{
+    std::atomic<int> pending;
+
+    JobCounter() : pending(0) {}
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// Pool de threads com roubo de trabalho. Cada thread (inclusive a que criou
+// o JobSystem, que é a thread 0) tem sua própria fila: quem envia um job o
+// coloca no fim da sua fila e retira do fim, e threads sem trabalho roubam
+// do início da fila das outras. Uma thread que espera por um contador
+// (wait(), parallelFor()) executa jobs enquanto espera, então jobs podem
+// enviar e esperar outros jobs.
+//
+// O JobSystem não garante ordem de execução; para resultados
+// determinísticos, cada job deve escrever só na sua parte da saída (veja
+// parallelFor()).
+class JobSystem
+{
+    public:
+        typedef std::function<void()> Job;
+        // Intervalo [begin, end) de índices
+        typedef std::function<void(size_t begin, size_t end)> RangeJob;
+
+        // threads = 0 usa uma thread por núcleo; threads = 1 executa tudo
+        // na thread que chama, sem criar nenhuma outra
+        JobSystem(unsigned int threads = 0);
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+        virtual ~JobSystem();
+
+        unsigned int threadCount() const { return workers.size(); }
+
+        void run(const Job& job, JobCounter& counter);
+        void wait(JobCounter& counter);
+
+        // Divide [begin, end) em blocos de "grain" índices, sempre nas mesmas
+        // fronteiras (begin, begin + grain, ...), e executa fn em cada um.
+        // O bloco k começa em begin + k*grain, o que permite a cada bloco
+        // escrever em uma saída própria e juntar tudo em ordem depois.
+        // Retorna quando todos os blocos terminaram.
+        void parallelFor(size_t begin, size_t end, size_t grain, const RangeJob& fn);
+
+    protected:
+
+    private:
+        struct Task
+        {
+            Job job;
+            JobCounter* counter;
+        };
+
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+            std::thread thread;
+        };
+
+        std::vector<Worker*> workers;
+        std::atomic<int> queued;  // tarefas em alguma fila
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        bool stopping;
+
+        unsigned int currentWorker() const;
+        bool pop(unsigned int self, Task& task);
+        bool steal(unsigned int self, Task& task);
+        bool runOne(unsigned int self);
+        void workerLoop(unsigned int self);
+};
+
+#endif // JOBSYSTEM_H
@@ -0,0 +1,92 @@
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// Arquivo binário com o resultado já processado de um modelo (buffers
+// prontos para a GPU, bounding boxes, dados de colisão...), para não
+// interpretar o ".obj" de novo a cada execução. O arquivo é uma lista de
+// blocos ("chunks") identificados por um código de 4 letras; o significado
+// de cada bloco é de quem escreve e lê (veja LoadMeshData() em "main.cpp").
+//
+// A validade é conferida contra os arquivos de origem: para cada um são
+// guardados tamanho, data de modificação e um hash do conteúdo. Se o
+// tamanho e a data batem, o hash nem é calculado; se só a data mudou (p.ex.
+// depois de um checkout), o hash decide. "version" deve mudar sempre que o
+// formato ou o processamento dos blocos mudar.
+//
+// Na leitura o arquivo é mapeado na memória (mmap / MapViewOfFile): os
+// ponteiros retornados por chunk() apontam direto para o mapeamento e podem
+// ser enviados à GPU sem cópia. Os blocos ficam alinhados a 16 bytes.
+
+#define MESH_CACHE_ID(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+class MeshCacheFile
+{
+    public:
+        MeshCacheFile();
+        MeshCacheFile(const MeshCacheFile&) = delete;
+        MeshCacheFile& operator=(const MeshCacheFile&) = delete;
+        virtual ~MeshCacheFile();
+
+        // Mapeia "path" se ele existir e for válido para "sources" e
+        // "version"; senão retorna false e nada fica aberto
+        bool open(const char* path, const std::vector<std::string>& sources, uint32_t version);
+        void close();
+
+        // Conteúdo do bloco "id", ou NULL se não houver
+        const void* chunk(uint32_t id, size_t* bytes) const;
+
+        template <typename T>
+        const T* chunkArray(uint32_t id, size_t* count) const
+        {
+            size_t bytes = 0;
+            const T* data = (const T*)chunk(id, &bytes);
+            *count = bytes / sizeof(T);
+            return data;
+        }
+
+    protected:
+
+    private:
+        const unsigned char* data;
+        size_t size;
+#ifdef _WIN32
+        void* file;
+        void* mapping;
+#endif
+};
+
+// Monta e grava um arquivo de cache. Os dados passados a add() só são lidos
+// em write() e precisam continuar válidos até lá.
+class MeshCacheWriter
+{
+    public:
+        void add(uint32_t id, const void* data, size_t bytes);
+
+        template <typename T>
+        void addArray(uint32_t id, const std::vector<T>& values)
+        {
+            add(id, values.empty() ? NULL : &values[0], values.size() * sizeof(T));
+        }
+
+        // Grava em um arquivo temporário e o renomeia para "path", para que
+        // uma execução interrompida não deixe um cache pela metade
+        bool write(const char* path, const std::vector<std::string>& sources, uint32_t version) const;
+
+    protected:
+
+    private:
+        struct Chunk
+        {
+            uint32_t id;
+            const void* data;
+            size_t bytes;
+        };
+        std::vector<Chunk> chunks;
+};
+
+#endif // MESHCACHE_H
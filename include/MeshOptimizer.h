@@ -0,0 +1,62 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Otimizações de malhas indexadas para o cache pós-transformação da GPU.
+// O caminho completo, como usado em BuildMesh() ("main.cpp"):
+//
+//   1. generateVertexRemap(): solda vértices idênticos, transformando uma
+//      lista de cantos de triângulo em vértices únicos + índices;
+//   2. optimizeVertexCache(): reordena os triângulos para reaproveitar os
+//      vértices recém-transformados (algoritmo de Tom Forsyth);
+//   3. optimizeOverdraw(): reordena grupos de triângulos para desenhar
+//      primeiro os que tendem a ficar na frente (Sander, Nehab e Barczak),
+//      sem piorar muito o uso do cache;
+//   4. optimizeVertexFetch(): renumera os vértices na ordem de primeiro uso,
+//      para que a leitura do buffer de vértices seja sequencial.
+
+// Tamanho do cache FIFO usado para medir ACMR/ATVR, próximo do de GPUs
+// sem cache de vértices propriamente dito (que processam em lotes)
+#define VERTEX_CACHE_FIFO_SIZE 16
+
+// Medidas de uma ordem de triângulos simulando um cache FIFO
+struct VertexCacheStats
+{
+    size_t triangles = 0;
+    size_t vertices = 0;      // vértices distintos referenciados
+    size_t transformed = 0;   // execuções do vertex shader (faltas no cache)
+    float acmr = 0.0f;        // transformed / triangles; 3 = nenhum reaproveitamento, ~0.5 = ótimo
+    float atvr = 0.0f;        // transformed / vertices; 1 = ótimo
+};
+
+// Vértices de "stride" bytes iguais byte a byte recebem o mesmo número.
+// remap[i] é o novo índice do vértice i; os vértices únicos são numerados
+// na ordem da primeira ocorrência. Retorna o número de vértices únicos.
+size_t generateVertexRemap(std::vector<uint32_t>& remap, const void* vertices, size_t vertex_count, size_t stride);
+
+// Copia os vértices únicos para "destination" (unique_count * stride bytes)
+void remapVertexBuffer(void* destination, const void* vertices, size_t vertex_count, size_t stride,
+                       const std::vector<uint32_t>& remap);
+
+// Reordena os triângulos de indices[0..index_count) in-place
+void optimizeVertexCache(uint32_t* indices, size_t index_count, size_t vertex_count);
+
+// Reordena, in-place, grupos de triângulos (já otimizados para o cache) de
+// fora para dentro. "positions" aponta para o x do vértice 0, com y e z em
+// seguida, e "position_stride" bytes entre vértices. O ACMR resultante não
+// passa de "threshold" vezes o original.
+void optimizeOverdraw(uint32_t* indices, size_t index_count, const float* positions, size_t vertex_count,
+                      size_t position_stride, float threshold = 1.05f);
+
+// Renumera os vértices na ordem em que os índices os usam pela primeira vez
+// (reescrevendo "indices"); remap[v] é o novo número do vértice v, ou
+// ~0u se nenhum índice o usa. Retorna o número de vértices usados.
+size_t optimizeVertexFetch(std::vector<uint32_t>& remap, uint32_t* indices, size_t index_count, size_t vertex_count);
+
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t index_count, size_t vertex_count,
+                                    unsigned int cache_size = VERTEX_CACHE_FIFO_SIZE);
+
+#endif // MESHOPTIMIZER_H
@@ -0,0 +1,25 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <stdint.h>
+#include <vector>
+#include <glm/vec3.hpp>
+
+// Simplificação de malhas de triângulos por colapso de arestas, ordenado
+// pela métrica de erro quádrico de Garland e Heckbert. Cada colapso junta um
+// vértice a um vizinho (u -> v), sem criar vértices novos, de forma que o
+// resultado é só uma nova lista de índices sobre os mesmos vértices e pode
+// ser desenhado com o VAO da malha original.
+//
+// "positions" são os vértices soldados (um por posição) e "indices" os
+// triângulos sobre eles, 3 por triângulo. Colapsos que invertem algum
+// triângulo, que deixam a malha não-manifold ou que movem vértices da borda
+// são recusados, então o resultado pode ter mais triângulos que o pedido.
+// Retorna os triângulos restantes, na ordem original; "error", se não for
+// NULL, recebe o maior erro quádrico aceito (distância ao quadrado).
+std::vector<uint32_t> simplifyMesh(const std::vector<glm::vec3>& positions,
+                                   const std::vector<uint32_t>& indices,
+                                   size_t target_triangles,
+                                   float* error = NULL);
+
+#endif // MESHSIMPLIFIER_H
@@ -0,0 +1,39 @@
+#ifndef OBJLOADER_H
+#define OBJLOADER_H
+
+#include <string>
+#include <vector>
+
+#include <tiny_obj_loader.h>
+
+#include "JobSystem.h"
+
+// Leitura de arquivos ".obj" em paralelo, com o mesmo resultado de
+// tinyobj::LoadObj() (mesmos attrib_t, shape_t e material_t, bit a bit),
+// mas sem std::istream e sem pow() por dígito:
+//
+//   1. o arquivo inteiro é lido para a memória e dividido em blocos de
+//      OBJ_LOADER_CHUNK_SIZE bytes, com as fronteiras ajustadas para o
+//      início de uma linha;
+//   2. os blocos são interpretados em paralelo no JobSystem: "v", "vn" e
+//      "vt" vão para vetores do bloco e as faces para uma lista de cantos
+//      já convertidos para índices base 0. Os demais comandos ("g", "o",
+//      "usemtl", "mtllib", "t") só são anotados;
+//   3. com as somas de prefixo do número de vértices de cada bloco, os
+//      vetores são copiados (em paralelo) para o attrib_t, corrigindo os
+//      índices relativos (negativos) das faces;
+//   4. os comandos anotados são reexecutados em ordem, montando as shapes
+//      exatamente como tinyobj::LoadObj() faria.
+//
+// Os números são lidos com a mesma aritmética de tinyobj (que não tem
+// arredondamento correto), para que os floats resultantes sejam iguais.
+
+#define OBJ_LOADER_CHUNK_SIZE (64 * 1024)
+
+// Mesma interface de tinyobj::LoadObj(), com o JobSystem onde rodar
+bool loadObjParallel(tinyobj::attrib_t* attrib, std::vector<tinyobj::shape_t>* shapes,
+                     std::vector<tinyobj::material_t>* materials, std::string* err,
+                     const char* filename, const char* mtl_basepath, bool triangulate,
+                     JobSystem& jobs);
+
+#endif // OBJLOADER_H
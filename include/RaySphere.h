@@ -0,0 +1,55 @@
+#ifndef RAYSPHERE_H
+#define RAYSPHERE_H
+
+#include <stdint.h>
+#include <vector>
+#include <glm/vec3.hpp>
+
+// Interseção em lote de segmentos de raio (os tiros) contra esferas (os
+// asteroides). Raios e esferas ficam em "structure of arrays", de forma que
+// o teste de um raio contra 4 (SSE) ou 8 (AVX) esferas é feito com uma
+// instrução por termo da equação do segundo grau, e blocos sem nenhuma raiz
+// real são descartados antes da raiz quadrada.
+
+// Esferas; "id" é devolvido em RayHit::sphere (p.ex. o índice do asteroide)
+class SpherePack
+{
+    public:
+        std::vector<float> x, y, z;
+        std::vector<float> radius2; // raio ao quadrado
+        std::vector<uint32_t> id;
+
+        size_t size() const { return id.size(); }
+        void clear();
+        void add(uint32_t id, glm::vec3 center, float radius);
+};
+
+// Segmentos P(t) = origin + direction*t, com 0 <= t <= tmax; "id" é
+// devolvido em RayHit::ray (p.ex. o índice do tiro)
+class RayPack
+{
+    public:
+        std::vector<float> ox, oy, oz;
+        std::vector<float> dx, dy, dz;
+        std::vector<float> a; // dot(direction, direction), calculado em add()
+        std::vector<float> tmax;
+        std::vector<uint32_t> id;
+
+        size_t size() const { return id.size(); }
+        void clear();
+        void add(uint32_t id, glm::vec3 origin, glm::vec3 direction, float tmax);
+};
+
+struct RayHit
+{
+    uint32_t ray;    // RayPack::id
+    uint32_t sphere; // SpherePack::id
+    float t;         // parâmetro de entrada na esfera (0 se o raio começa dentro dela)
+};
+
+// Testa o raio de índice "ray" contra todas as esferas e acrescenta os
+// acertos em "hits", na ordem das esferas. GameWorld::testBullets() chama
+// um raio por vez, para dividir os tiros entre jobs.
+void intersectRay(const RayPack& rays, size_t ray, const SpherePack& spheres, std::vector<RayHit>& hits);
+
+#endif // RAYSPHERE_H
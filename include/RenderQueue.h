@@ -0,0 +1,97 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <stdint.h>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include "shader.h"
+
+// Variáveis "uniform" que a fila altera entre um desenho e outro, para um
+// programa de GPU. Os handles lembram o último valor enviado, então um
+// valor repetido não é reenviado nem de um quadro para o outro.
+struct RenderUniforms
+{
+    UniformHandle<glm::mat4> model;
+    UniformHandle<int>       object_id;
+    UniformHandle<int>       need_texture;
+    UniformHandle<int>       instanced;
+    UniformHandle<glm::vec4> bbox_min;
+    UniformHandle<glm::vec4> bbox_max;
+    UniformHandle<int>       material_base;
+};
+
+// Um desenho pendente: tudo que é preciso para emiti-lo mais tarde, em
+// qualquer ordem
+struct DrawItem
+{
+    GLuint program;
+    RenderUniforms* uniforms; // handles de "program"
+    GLuint vertex_array_object_id;
+    GLenum rendering_mode;
+    size_t first_index;
+    size_t num_indices;
+    GLsizei instances; // 0 = desenho simples com "model"; senão usa o buffer de instâncias do VAO
+    int object_id;
+    int need_texture;
+    int material_base; // veja "material_base" em shader_vertex.glsl
+    glm::mat4 model;
+    glm::vec3 bbox_min;
+    glm::vec3 bbox_max;
+    float depth; // distância até a câmera, para ordenar da frente para trás
+};
+
+// Contadores do último RenderQueue::flush(). Um "bind" é qualquer troca de
+// estado: programa, VAO ou uniform de material (object_id, need_texture,
+// instanced, bbox, material_base).
+struct RenderStats
+{
+    unsigned int draws = 0;
+    unsigned int binds = 0;
+    unsigned int bindsAvoided = 0; // trocas puladas porque o estado já era o pedido
+};
+
+// Fila de desenhos do quadro. Os itens são enviados em qualquer ordem com
+// submit(); flush() ordena por uma chave de 64 bits (programa, VAO,
+// material e profundidade, nessa prioridade) com radix sort e emite os
+// desenhos pulando as trocas de estado redundantes. Objetos opacos saem da
+// frente para trás, aproveitando o early-z; o que deve ser desenhado por
+// último (o skybox) fica fora da fila, depois do flush().
+class RenderQueue
+{
+    public:
+        RenderStats stats;
+
+        // max_depth: profundidade mapeada para o fim da escala da chave
+        RenderQueue(float max_depth);
+        virtual ~RenderQueue();
+
+        void submit(const DrawItem& item);
+        void flush(); // ordena, desenha e esvazia a fila
+        size_t size() const { return items.size(); }
+
+    protected:
+
+    private:
+        float maxDepth;
+        std::vector<DrawItem> items;
+        std::vector<uint64_t> keys, keysScratch;
+        std::vector<uint32_t> order, orderScratch;
+
+        uint64_t sortKey(const DrawItem& item) const;
+        void sort();
+        void count(bool uploaded); // soma uma troca feita ou evitada em stats
+
+        // Envia o valor e o conta em stats; uniforms que o programa não tem
+        // (location -1) não contam nem como troca nem como troca evitada
+        template <typename T>
+        void set(UniformHandle<T>& handle, const T& value)
+        {
+            if (handle.location >= 0)
+                count(handle.set(value));
+        }
+};
+
+#endif // RENDERQUEUE_H
@@ -0,0 +1,120 @@
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Referência estável para uma entidade (asteroide, tiro, ...). Continua
+// identificando a mesma entidade mesmo depois que outras são removidas, e
+// deixa de ser válida quando a entidade é destruída: o slot pode ser
+// reutilizado, mas com outra geração.
+struct EntityHandle
+{
+    uint32_t index = 0;      // slot em HandleTable
+    uint32_t generation = 0; // 0 nunca é uma geração válida
+
+    bool operator==(const EntityHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const EntityHandle& other) const { return !(*this == other); }
+};
+
+// Tabela de indireção entre handles e o índice do elemento no vetor denso do
+// dono (um std::vector, ou as colunas de AsteroidField). O dono mantém os
+// dados compactos com swap-and-pop; a tabela só acompanha quem foi parar
+// onde. Destruições são adiadas com destroyLater() e aplicadas pelo dono de
+// uma só vez, no fim do tick.
+class HandleTable
+{
+    public:
+        // Registra um novo elemento, que o dono acabou de colocar no fim do vetor denso
+        EntityHandle add()
+        {
+            uint32_t slot;
+            if (!freeSlots.empty()) {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            } else {
+                slot = slots.size();
+                slots.push_back(Slot());
+            }
+            slots[slot].dense = denseToSlot.size();
+            slots[slot].dying = false;
+            denseToSlot.push_back(slot);
+
+            EntityHandle handle;
+            handle.index = slot;
+            handle.generation = slots[slot].generation;
+            return handle;
+        }
+
+        // O dono moveu o último elemento denso para a posição "dense" (swap-and-pop)
+        void removeAt(size_t dense)
+        {
+            uint32_t slot = denseToSlot[dense];
+            uint32_t last = denseToSlot.back();
+            denseToSlot[dense] = last;
+            slots[last].dense = dense;
+            denseToSlot.pop_back();
+
+            slots[slot].generation++;
+            if (slots[slot].generation == 0)
+                slots[slot].generation = 1;
+            slots[slot].dying = false;
+            freeSlots.push_back(slot);
+        }
+
+        bool valid(EntityHandle handle) const
+        {
+            return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+        }
+
+        size_t indexOf(EntityHandle handle) const { return slots[handle.index].dense; }
+
+        EntityHandle handleAt(size_t dense) const
+        {
+            EntityHandle handle;
+            handle.index = denseToSlot[dense];
+            handle.generation = slots[handle.index].generation;
+            return handle;
+        }
+
+        size_t size() const { return denseToSlot.size(); }
+
+        // Marca para destruição no próximo flush do dono. Retorna false se o
+        // handle já não é válido ou já estava marcado.
+        bool destroyLater(EntityHandle handle)
+        {
+            if (!valid(handle) || slots[handle.index].dying)
+                return false;
+            slots[handle.index].dying = true;
+            pendingDestroy.push_back(handle);
+            return true;
+        }
+
+        bool isDying(size_t dense) const { return slots[denseToSlot[dense]].dying; }
+
+        const std::vector<EntityHandle>& pending() const { return pendingDestroy; }
+        void clearPending() { pendingDestroy.clear(); }
+
+        void clear()
+        {
+            while (!denseToSlot.empty())
+                removeAt(denseToSlot.size() - 1);
+            pendingDestroy.clear();
+        }
+
+    private:
+        struct Slot
+        {
+            uint32_t dense = 0;
+            uint32_t generation = 1;
+            bool dying = false;
+        };
+
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+        std::vector<uint32_t> denseToSlot;
+        std::vector<EntityHandle> pendingDestroy;
+};
+
+#endif // SLOTMAP_H
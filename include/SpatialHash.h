@@ -0,0 +1,55 @@
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include <stdint.h>
+#include <vector>
+#include <utility>
+#include <glm/vec3.hpp>
+
+// Broadphase por grade uniforme. Cada item (identificado por um inteiro, por
+// exemplo o índice de um asteroide) é inserido em todas as células que sua
+// AABB toca. Depois de build(), findPairs() devolve somente os pares de itens
+// que compartilham alguma célula e cujas AABBs se sobrepõem, e query() devolve
+// os itens próximos de uma AABB qualquer. É reconstruída a cada tick; depois
+// de build(), as consultas (const) podem ser feitas de várias threads.
+class SpatialHash
+{
+    public:
+        float cellSize;
+
+        SpatialHash(float cellSize);
+        virtual ~SpatialHash();
+
+        void clear();
+        void insert(uint32_t id, glm::vec3 bbox_min, glm::vec3 bbox_max);
+        void build(); // ordena as células; chamar depois dos insert()
+
+        // Pares (a, b) com a < b, sem repetição, ordenados por a e depois b
+        void findPairs(std::vector<std::pair<uint32_t, uint32_t> >& pairs) const;
+        // Itens cuja AABB sobrepõe a AABB dada, sem repetição, ordenados
+        void query(glm::vec3 bbox_min, glm::vec3 bbox_max, std::vector<uint32_t>& ids) const;
+        // Itens em alguma célula atravessada pelo segmento p0-p1 (percorrida
+        // como em um DDA 3D), sem repetição, ordenados
+        void querySegment(glm::vec3 p0, glm::vec3 p1, std::vector<uint32_t>& ids) const;
+
+    protected:
+
+    private:
+        struct Entry
+        {
+            uint64_t cell;
+            uint32_t id;
+            bool operator<(const Entry& other) const { return cell < other.cell || (cell == other.cell && id < other.id); }
+        };
+
+        std::vector<Entry> entries;
+        std::vector<glm::vec3> itemMin, itemMax;
+
+        glm::ivec3 cellCoords(glm::vec3 p) const;
+        static uint64_t cellKey(glm::ivec3 c);
+        bool overlaps(uint32_t id, glm::vec3 bbox_min, glm::vec3 bbox_max) const;
+        void endQuery(std::vector<uint32_t>& ids) const;
+        void collectCell(glm::ivec3 cell, glm::vec3 bbox_min, glm::vec3 bbox_max, std::vector<uint32_t>& ids) const;
+};
+
+#endif // SPATIALHASH_H
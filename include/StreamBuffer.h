@@ -0,0 +1,73 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <stddef.h>
+#include <vector>
+#include <glad/glad.h>
+
+// Número de quadros que o buffer guarda ao mesmo tempo: o que a CPU está
+// escrevendo e até dois que a GPU ainda pode estar lendo
+#define STREAM_BUFFER_FRAMES 3
+
+// Contadores de um quadro de StreamBuffer
+struct StreamStats
+{
+    size_t bytes = 0;          // escritos no quadro
+    unsigned int writes = 0;
+    unsigned int orphans = 0;  // trechos ainda em uso pela GPU, trocados por memória nova em vez de esperar
+    unsigned int grows = 0;    // vezes em que um quadro não coube e o buffer cresceu
+};
+
+// Buffer de vértices para dados que mudam a cada quadro (matrizes de
+// instâncias, quadriláteros de texto). O buffer é
+// dividido em STREAM_BUFFER_FRAMES trechos, um por quadro, usados em
+// rodízio: cada write() copia os dados para o fim do trecho do quadro atual
+// (glMapBufferRange sem sincronização) e retorna o deslocamento em bytes,
+// a ser usado em glVertexAttribPointer ou glDrawArrays.
+//
+// endFrame() coloca uma fence (glFenceSync) no trecho que acabou e passa
+// para o próximo. Se a GPU ainda não terminou de ler o próximo trecho, o
+// buffer inteiro é "órfão" (glBufferData com NULL) em vez de esperar: o
+// driver entrega memória nova e a escrita nunca fica parada. Sem suporte a
+// fences, o buffer fica órfão a cada volta completa.
+//
+// Os deslocamentos retornados só valem até o endFrame(); o buffer (id())
+// é sempre o mesmo.
+class StreamBuffer
+{
+    public:
+        StreamStats lastFrame; // contadores do último quadro terminado
+
+        // frame_capacity: bytes por quadro; cresce se não for suficiente
+        StreamBuffer(size_t frame_capacity, unsigned int frames = STREAM_BUFFER_FRAMES);
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+        virtual ~StreamBuffer();
+
+        GLuint id() const { return buffer_id; }
+
+        // Copia "bytes" bytes para o buffer, em um deslocamento múltiplo de
+        // "alignment", e retorna esse deslocamento
+        size_t write(const void* data, size_t bytes, size_t alignment = 16);
+        void endFrame();
+
+    protected:
+
+    private:
+        GLuint buffer_id;
+        unsigned int frames;
+        size_t segmentSize;
+        unsigned int segment;   // trecho do quadro atual
+        size_t frameBase;       // início do trecho do quadro atual
+        size_t head;            // bytes usados no trecho
+        std::vector<GLsync> fences;
+        bool grown;
+        bool useFences;
+        StreamStats stats;
+
+        void orphan(size_t size);
+        void grow(size_t needed);
+        void deleteFences();
+};
+
+#endif // STREAMBUFFER_H
@@ -0,0 +1,47 @@
+#ifndef TEXTURECOOKER_H
+#define TEXTURECOOKER_H
+
+#include <stddef.h>
+#include <vector>
+
+#include "JobSystem.h"
+
+// Preparação de texturas na CPU, para que a GPU só receba os dados prontos:
+//
+//   1. a cadeia de mipmaps é gerada com gamma correto: os texels (sRGB) são
+//      convertidos para linear, filtrados com uma caixa 2x2 e convertidos de
+//      volta para sRGB. Cada nível é filtrado a partir do anterior ainda em
+//      float, sem arredondar para 8 bits no caminho;
+//   2. cada nível é codificado em blocos de 4x4 texels no formato pedido:
+//        TEXTURE_RGB8  sem compressão, 3 bytes por texel;
+//        TEXTURE_BC1   S3TC/DXT1, 8 bytes por bloco (0.5 byte por texel);
+//        TEXTURE_BC7   BPTC, 16 bytes por bloco (1 byte por texel), só o
+//                      modo 6 (um subconjunto, índices de 4 bits), bem mais
+//                      fiel que BC1 em gradientes.
+//
+// O resultado tem os níveis um após o outro, do maior para o menor, no
+// formato que glTexImage2D()/glCompressedTexImage2D() esperam (linhas sem
+// alinhamento em TEXTURE_RGB8). Blocos de níveis menores que 4x4 são
+// completados repetindo a última linha/coluna.
+
+#define TEXTURE_RGB8 0
+#define TEXTURE_BC1  1
+#define TEXTURE_BC7  2
+
+// Número de níveis de mipmap até 1x1
+int textureLevelCount(int width, int height);
+
+// Bytes de um nível de "width" x "height" texels no formato "format"
+size_t textureLevelBytes(int format, int width, int height);
+
+// Gera os mipmaps da imagem "rgb" (sRGB, 3 bytes por texel, sem alinhamento)
+// e os codifica em "format", acrescentando tudo a "out". Os blocos de cada
+// nível são codificados em paralelo no JobSystem. Retorna o número de níveis.
+int cookTexture(const unsigned char* rgb, int width, int height, int format,
+                std::vector<unsigned char>* out, JobSystem& jobs);
+
+// Codificam um bloco de 4x4 texels RGB (48 bytes, linha a linha)
+void encodeBC1Block(const unsigned char* rgb, unsigned char* block);
+void encodeBC7Block(const unsigned char* rgb, unsigned char* block);
+
+#endif // TEXTURECOOKER_H
@@ -0,0 +1,36 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+// Curva cúbica na base de potências:
+//
+//     P(t) = a*t^3 + b*t^2 + c*t + d
+//
+// Convertida uma única vez a partir dos pontos de controle de uma curva de
+// bezier, de forma que avaliar a posição é um passo de Horner e a
+// velocidade e o volume varrido em um intervalo têm forma fechada.
+class Trajectory
+{
+    public:
+        glm::vec3 a, b, c, d;
+
+        Trajectory();
+        Trajectory(glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 d);
+        virtual ~Trajectory();
+
+        static Trajectory fromBezier(glm::vec4 p0, glm::vec4 p1, glm::vec4 p2, glm::vec4 p3);
+
+        glm::vec4 position(float t) const; // ponto (w = 1)
+        glm::vec4 velocity(float t) const; // dP/dt (w = 0)
+
+        // Axis-aligned bounding box exata da curva para t em [t0, t1]
+        void bounds(float t0, float t1, glm::vec3& bbox_min, glm::vec3& bbox_max) const;
+
+    protected:
+
+    private:
+};
+
+#endif // TRAJECTORY_H
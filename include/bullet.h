@@ -6,10 +6,10 @@
 class bullet
 {
     public:
-        float t = 0.0f;
         glm::vec4 start_position;
         glm::vec4 direction; // speed too
-        glm::vec4 current_position;
+        float spawn_time = 0.0f;  // preenchidos por BulletPool::add()
+        float expire_time = 0.0f;
 
         bullet();
         bullet(glm::vec4 position, glm::vec4 direction);
@@ -17,7 +17,9 @@ class bullet
 
         glm::vec4 cartesianDirection();
         float speedGap(float deltaTime);
-        glm::vec4 computeNewPosition(float deltaTime);
+        // Movimento retilíneo uniforme: a posição sai direto do tempo
+        glm::vec4 position(float time) const { return start_position + direction * (time - spawn_time); }
+        float age(float time) const { return time - spawn_time; }
 
     protected:
 
@@ -27,7 +27,7 @@
 //
 // Para conseguirmos definir matrizes através de suas LINHAS, a função Matrix()
 // computa a transposta usando os elementos passados por parâmetros.
-glm::mat4 Matrix(
+inline glm::mat4 Matrix(
     float m00, float m01, float m02, float m03, // LINHA 1
     float m10, float m11, float m12, float m13, // LINHA 2
     float m20, float m21, float m22, float m23, // LINHA 3
@@ -43,7 +43,7 @@ glm::mat4 Matrix(
 }
 
 // Matriz identidade.
-glm::mat4 Matrix_Identity()
+inline glm::mat4 Matrix_Identity()
 {
     return Matrix(
         1.0f , 0.0f , 0.0f , 0.0f , // LINHA 1
@@ -59,7 +59,7 @@ glm::mat4 Matrix_Identity()
 //
 //     T*p = p+t.
 //
-glm::mat4 Matrix_Translate(float tx, float ty, float tz)
+inline glm::mat4 Matrix_Translate(float tx, float ty, float tz)
 {
     return Matrix(
         1.0f , 0.0f , 0.0f , tx ,
@@ -69,7 +69,7 @@ glm::mat4 Matrix_Translate(float tx, float ty, float tz)
     );
 }
 
-glm::mat4 Matrix_Translate(glm::vec4 t)
+inline glm::mat4 Matrix_Translate(glm::vec4 t)
 {
     return Matrix(
         1.0f , 0.0f , 0.0f , t.x ,
@@ -85,7 +85,7 @@ glm::mat4 Matrix_Translate(glm::vec4 t)
 //
 //     S*p = [sx*px, sy*py, sz*pz, pw].
 //
-glm::mat4 Matrix_Scale(float sx, float sy, float sz)
+inline glm::mat4 Matrix_Scale(float sx, float sy, float sz)
 {
     return Matrix(
         sx   , 0.0f , 0.0f , 0.0f ,
@@ -103,7 +103,7 @@ glm::mat4 Matrix_Scale(float sx, float sy, float sz)
 //   R*p = [ px, c*py-s*pz, s*py+c*pz, pw ];
 //
 // onde 'c' e 's' são o cosseno e o seno do ângulo de rotação, respectivamente.
-glm::mat4 Matrix_Rotate_X(float angle)
+inline glm::mat4 Matrix_Rotate_X(float angle)
 {
     float c = cos(angle);
     float s = sin(angle);
@@ -123,7 +123,7 @@ glm::mat4 Matrix_Rotate_X(float angle)
 //   R*p = [ c*px+s*pz, py, -s*px+c*pz, pw ];
 //
 // onde 'c' e 's' são o cosseno e o seno do ângulo de rotação, respectivamente.
-glm::mat4 Matrix_Rotate_Y(float angle)
+inline glm::mat4 Matrix_Rotate_Y(float angle)
 {
     float c = cos(angle);
     float s = sin(angle);
@@ -143,7 +143,7 @@ glm::mat4 Matrix_Rotate_Y(float angle)
 //   R*p = [ c*px-s*py, s*px+c*py, pz, pw ];
 //
 // onde 'c' e 's' são o cosseno e o seno do ângulo de rotação, respectivamente.
-glm::mat4 Matrix_Rotate_Z(float angle)
+inline glm::mat4 Matrix_Rotate_Z(float angle)
 {
     float c = cos(angle);
     float s = sin(angle);
@@ -157,7 +157,7 @@ glm::mat4 Matrix_Rotate_Z(float angle)
 
 // Função que calcula a norma Euclidiana de um vetor cujos coeficientes são
 // definidos em uma base ortonormal qualquer.
-float norm(glm::vec4 v)
+inline float norm(glm::vec4 v)
 {
     float vx = v.x;
     float vy = v.y;
@@ -166,7 +166,7 @@ float norm(glm::vec4 v)
     return sqrt( vx*vx + vy*vy + vz*vz );
 }
 
-glm::vec4 matrixVectorProduct(glm::mat4 m, glm::vec4 v) {
+inline glm::vec4 matrixVectorProduct(glm::mat4 m, glm::vec4 v) {
     float vx = m[0][0] * v.x + m[1][0] * v.y + m[2][0] * v.z + m[3][0];
     float vy = m[0][1] * v.x + m[1][1] * v.y + m[2][1] * v.z + m[3][1];
     float vz = m[0][2] * v.x + m[1][2] * v.y + m[2][2] * v.z + m[3][2];
@@ -178,7 +178,7 @@ glm::vec4 matrixVectorProduct(glm::mat4 m, glm::vec4 v) {
 // coordenadas e em torno do eixo definido pelo vetor 'axis'. Esta matriz pode
 // ser definida pela fórmula de Rodrigues. Lembre-se que o vetor que define o
 // eixo de rotação deve ser normalizado!
-glm::mat4 Matrix_Rotate(float angle, glm::vec4 axis)
+inline glm::mat4 Matrix_Rotate(float angle, glm::vec4 axis)
 {
     float c = cos(angle);
     float s = sin(angle);
@@ -199,7 +199,7 @@ glm::mat4 Matrix_Rotate(float angle, glm::vec4 axis)
 
 // Produto vetorial entre dois vetores u e v definidos em um sistema de
 // coordenadas ortonormal.
-glm::vec4 crossproduct(glm::vec4 u, glm::vec4 v)
+inline glm::vec4 crossproduct(glm::vec4 u, glm::vec4 v)
 {
     float u1 = u.x;
     float u2 = u.y;
@@ -217,7 +217,7 @@ glm::vec4 crossproduct(glm::vec4 u, glm::vec4 v)
 }
 
 // Produto escalar
-glm::vec4 scalarproduct(glm::vec4 u, float a)
+inline glm::vec4 scalarproduct(glm::vec4 u, float a)
 {
     float u1 = u.x;
     float u2 = u.y;
@@ -233,7 +233,7 @@ glm::vec4 scalarproduct(glm::vec4 u, float a)
 
 // Produto escalar entre dois vetores u e v definidos em um sistema de
 // coordenadas ortonormal.
-float dotproduct(glm::vec4 u, glm::vec4 v)
+inline float dotproduct(glm::vec4 u, glm::vec4 v)
 {
     float u1 = u.x;
     float u2 = u.y;
@@ -254,7 +254,7 @@ float dotproduct(glm::vec4 u, glm::vec4 v)
 }
 
 // Matriz de mudança de coordenadas para o sistema de coordenadas da Câmera.
-glm::mat4 Matrix_Camera_View(glm::vec4 position_c, glm::vec4 view_vector, glm::vec4 up_vector)
+inline glm::mat4 Matrix_Camera_View(glm::vec4 position_c, glm::vec4 view_vector, glm::vec4 up_vector)
 {
     glm::vec4 w = -view_vector;
     glm::vec4 u = crossproduct(up_vector, w);
@@ -286,7 +286,7 @@ glm::mat4 Matrix_Camera_View(glm::vec4 position_c, glm::vec4 view_vector, glm::v
 }
 
 // Matriz de projeção paralela ortográfica
-glm::mat4 Matrix_Orthographic(float l, float r, float b, float t, float n, float f)
+inline glm::mat4 Matrix_Orthographic(float l, float r, float b, float t, float n, float f)
 {
     glm::mat4 M = Matrix(
         2.0f/(r-l) , 0.0f       , 0.0f       , -(r+l)/(r-l) ,
@@ -299,7 +299,7 @@ glm::mat4 Matrix_Orthographic(float l, float r, float b, float t, float n, float
 }
 
 // Matriz de projeção perspectiva
-glm::mat4 Matrix_Perspective(float field_of_view, float aspect, float n, float f)
+inline glm::mat4 Matrix_Perspective(float field_of_view, float aspect, float n, float f)
 {
     float t = fabs(n) * tanf(field_of_view / 2.0f);
     float b = -t;
@@ -353,7 +353,7 @@ glm::mat4 Matrix_Perspective(float field_of_view, float aspect, float n, float f
     return -M*P;
 }
 
-glm::vec4 toCartesianFromSpherical(float r, float theta, float phi) {
+inline glm::vec4 toCartesianFromSpherical(float r, float theta, float phi) {
     return glm::vec4(r * cos(phi) * sin(theta),
                      r * sin(phi),
                      r * cos(phi) * cos(theta),
@@ -362,7 +362,7 @@ glm::vec4 toCartesianFromSpherical(float r, float theta, float phi) {
 
 
 // Função que imprime uma matriz M no terminal
-void PrintMatrix(glm::mat4 M)
+inline void PrintMatrix(glm::mat4 M)
 {
     printf("\n");
     printf("[ %+0.2f  %+0.2f  %+0.2f  %+0.2f ]\n", M[0][0], M[1][0], M[2][0], M[3][0]);
@@ -372,7 +372,7 @@ void PrintMatrix(glm::mat4 M)
 }
 
 // Função que imprime um vetor v no terminal
-void PrintVector(glm::vec4 v)
+inline void PrintVector(glm::vec4 v)
 {
     printf("\n");
     printf("[ %+0.2f ]\n", v[0]);
@@ -382,7 +382,7 @@ void PrintVector(glm::vec4 v)
 }
 
 // Função que imprime o produto de uma matriz por um vetor no terminal
-void PrintMatrixVectorProduct(glm::mat4 M, glm::vec4 v)
+inline void PrintMatrixVectorProduct(glm::mat4 M, glm::vec4 v)
 {
     auto r = M*v;
     printf("\n");
@@ -394,7 +394,7 @@ void PrintMatrixVectorProduct(glm::mat4 M, glm::vec4 v)
 
 // Função que imprime o produto de uma matriz por um vetor, junto com divisão
 // por w, no terminal.
-void PrintMatrixVectorProductDivW(glm::mat4 M, glm::vec4 v)
+inline void PrintMatrixVectorProductDivW(glm::mat4 M, glm::vec4 v)
 {
     auto r = M*v;
     auto w = r[3];
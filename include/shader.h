@@ -5,10 +5,89 @@
 #include <glm/glm.hpp>
 
 #include <string>
+#include <vector>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+// How each C++ type maps to a GLSL uniform type and to a glUniform* call
+template <typename T> struct UniformTraits;
+
+template <> struct UniformTraits<int>
+{
+    // samplers are set as ints too
+    static bool accepts(GLenum type) { return type == GL_INT || type == GL_BOOL || type == GL_SAMPLER_2D || type == GL_SAMPLER_CUBE; }
+    static void upload(GLint location, const int& value) { glUniform1i(location, value); }
+};
+template <> struct UniformTraits<float>
+{
+    static bool accepts(GLenum type) { return type == GL_FLOAT; }
+    static void upload(GLint location, const float& value) { glUniform1f(location, value); }
+};
+template <> struct UniformTraits<glm::vec2>
+{
+    static bool accepts(GLenum type) { return type == GL_FLOAT_VEC2; }
+    static void upload(GLint location, const glm::vec2& value) { glUniform2fv(location, 1, &value[0]); }
+};
+template <> struct UniformTraits<glm::vec3>
+{
+    static bool accepts(GLenum type) { return type == GL_FLOAT_VEC3; }
+    static void upload(GLint location, const glm::vec3& value) { glUniform3fv(location, 1, &value[0]); }
+};
+template <> struct UniformTraits<glm::vec4>
+{
+    static bool accepts(GLenum type) { return type == GL_FLOAT_VEC4; }
+    static void upload(GLint location, const glm::vec4& value) { glUniform4fv(location, 1, &value[0]); }
+};
+template <> struct UniformTraits<glm::mat2>
+{
+    static bool accepts(GLenum type) { return type == GL_FLOAT_MAT2; }
+    static void upload(GLint location, const glm::mat2& value) { glUniformMatrix2fv(location, 1, GL_FALSE, &value[0][0]); }
+};
+template <> struct UniformTraits<glm::mat3>
+{
+    static bool accepts(GLenum type) { return type == GL_FLOAT_MAT3; }
+    static void upload(GLint location, const glm::mat3& value) { glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]); }
+};
+template <> struct UniformTraits<glm::mat4>
+{
+    static bool accepts(GLenum type) { return type == GL_FLOAT_MAT4; }
+    static void upload(GLint location, const glm::mat4& value) { glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]); }
+};
+
+// A uniform of one program, resolved once with Shader::uniform<T>(). set()
+// uploads only when the value differs from the last one this handle sent,
+// so keep a single handle per uniform. The program must be in use when
+// set() is called. A handle for a uniform the program does not have (or
+// that the compiler optimized out) has location -1 and set() does nothing.
+template <typename T>
+class UniformHandle
+{
+public:
+    GLint location;
+
+    UniformHandle() : location(-1), cached(), has_value(false) {}
+    explicit UniformHandle(GLint location) : location(location), cached(), has_value(false) {}
+
+    // returns true if the value was uploaded
+    bool set(const T& value)
+    {
+        if (location < 0 || (has_value && cached == value))
+            return false;
+        UniformTraits<T>::upload(location, value);
+        cached = value;
+        has_value = true;
+        return true;
+    }
+    // forget the cached value, e.g. after the uniform was set some other way
+    void invalidate() { has_value = false; }
+
+private:
+    T cached;
+    bool has_value;
+};
+
 class Shader
 {
 public:
@@ -95,6 +174,7 @@ public:
         if(geometryPath != nullptr)
             glDeleteShader(geometry);
 
+        reflectUniforms();
     }
     // activate the shader
     // ------------------------------------------------------------------------
@@ -102,66 +182,134 @@ public:
     { 
         glUseProgram(ID); 
     }
-    // utility uniform functions
+    // typed handle to a uniform, resolved once (at load time, not per frame)
     // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
-    {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    template <typename T>
+    UniformHandle<T> uniform(const char* name) const
+    {
+        const UniformInfo* info = findUniform(name);
+        if (info == nullptr)
+            return UniformHandle<T>();
+        if (!UniformTraits<T>::accepts(info->type))
+        {
+            std::cout << "ERROR::SHADER::UNIFORM_TYPE_MISMATCH: " << name << std::endl;
+            return UniformHandle<T>();
+        }
+        return UniformHandle<T>(info->location);
     }
+    // utility uniform functions, for one-off setup; the name is looked up in
+    // the uniforms reflected at link time, without calling the driver
     // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
-    { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+    void setBool(const char* name, bool value) const
+    {
+        glUniform1i(location(name), (int)value);
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
-    { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+    void setInt(const char* name, int value) const
+    {
+        glUniform1i(location(name), value);
     }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value) const
-    { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    void setFloat(const char* name, float value) const
+    {
+        glUniform1f(location(name), value);
     }
-    void setVec2(const std::string &name, float x, float y) const
-    { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+    // ------------------------------------------------------------------------
+    void setVec2(const char* name, const glm::vec2 &value) const
+    {
+        glUniform2fv(location(name), 1, &value[0]);
+    }
+    void setVec2(const char* name, float x, float y) const
+    {
+        glUniform2f(location(name), x, y);
     }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value) const
-    { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    void setVec3(const char* name, const glm::vec3 &value) const
+    {
+        glUniform3fv(location(name), 1, &value[0]);
     }
-    void setVec3(const std::string &name, float x, float y, float z) const
-    { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+    void setVec3(const char* name, float x, float y, float z) const
+    {
+        glUniform3f(location(name), x, y, z);
     }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value) const
-    { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    void setVec4(const char* name, const glm::vec4 &value) const
+    {
+        glUniform4fv(location(name), 1, &value[0]);
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w) 
-    { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+    void setVec4(const char* name, float x, float y, float z, float w) const
+    {
+        glUniform4f(location(name), x, y, z, w);
+    }
+    // elements 0 to count-1 of a "uniform vec4 name[N]" array
+    void setVec4Array(const char* name, const glm::vec4* values, GLsizei count) const
+    {
+        glUniform4fv(location(name), count, &values[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    void setMat2(const char* name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    void setMat3(const char* name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    void setMat4(const char* name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
+    struct UniformInfo
+    {
+        std::string name;
+        GLint location;
+        GLenum type;
+    };
+    // active uniforms outside of uniform blocks
+    std::vector<UniformInfo> uniforms;
+
+    // list the active uniforms once, right after linking
+    // ------------------------------------------------------------------------
+    void reflectUniforms()
+    {
+        GLint count = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLchar name[256];
+            GLsizei length;
+            GLint size;
+            GLenum type;
+            glGetActiveUniform(ID, i, sizeof(name), &length, &size, &type, name);
+
+            UniformInfo info;
+            info.name = std::string(name, length);
+            // arrays are reported as "name[0]"
+            if (info.name.size() > 3 && info.name.compare(info.name.size() - 3, 3, "[0]") == 0)
+                info.name.resize(info.name.size() - 3);
+            info.location = glGetUniformLocation(ID, name);
+            info.type = type;
+            if (info.location >= 0) // members of uniform blocks have no location
+                uniforms.push_back(info);
+        }
+    }
+    // ------------------------------------------------------------------------
+    const UniformInfo* findUniform(const char* name) const
+    {
+        for (size_t i = 0; i < uniforms.size(); i++)
+            if (std::strcmp(uniforms[i].name.c_str(), name) == 0)
+                return &uniforms[i];
+        return nullptr;
+    }
+    GLint location(const char* name) const
+    {
+        const UniformInfo* info = findUniform(name);
+        return info != nullptr ? info->location : -1;
+    }
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
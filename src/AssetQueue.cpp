@@ -0,0 +1,64 @@
+#include "AssetQueue.h"
+
+#include <chrono>
+
+AssetQueue::AssetQueue(JobSystem& jobs)
+    : jobs(jobs), next(0), requested(0), completed(0)
+{
+    //ctor
+}
+
+AssetQueue::~AssetQueue()
+{
+    jobs.wait(counter);
+}
+
+void AssetQueue::load(const Load& load)
+{
+    requested++;
+    jobs.run([this, load] {
+        std::vector<Upload> uploads;
+        load(uploads);
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.push_back(std::vector<Upload>());
+        ready.back().swap(uploads);
+    }, counter);
+}
+
+unsigned int AssetQueue::update(double budget)
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    unsigned int count = 0;
+    for (;;) {
+        Upload upload;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            // cargas sem (mais) envios estão completas
+            while (!ready.empty() && next == ready.front().size()) {
+                ready.pop_front();
+                next = 0;
+                completed++;
+            }
+            if (ready.empty())
+                break;
+            upload.swap(ready.front()[next++]);
+        }
+
+        upload();
+        count++;
+
+        if (std::chrono::duration<double>(Clock::now() - start).count() >= budget)
+            break;
+    }
+
+    // A última carga enviada já conta como completa neste quadro
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!ready.empty() && next == ready.front().size()) {
+        ready.pop_front();
+        next = 0;
+        completed++;
+    }
+    return count;
+}
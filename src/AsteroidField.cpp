@@ -0,0 +1,189 @@
+#include "AsteroidField.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ASTEROIDFIELD_X86
+#include <immintrin.h>
+#endif
+
+AsteroidField::AsteroidField()
+{
+    std::vector<float>* all[NUM_COLUMNS] = {
+        &px, &py, &pz,
+        &t, &velocity, &scale,
+        &rx, &ry, &rz,
+        &ax, &ay, &az,
+        &bx, &by, &bz,
+        &cx, &cy, &cz,
+        &dx, &dy, &dz
+    };
+    for (int c = 0; c < NUM_COLUMNS; c++)
+        columns[c] = all[c];
+}
+
+AsteroidField::~AsteroidField()
+{
+    //dtor
+}
+
+EntityHandle AsteroidField::add(const Asteroid& asteroid)
+{
+    px.push_back(asteroid.position.x);
+    py.push_back(asteroid.position.y);
+    pz.push_back(asteroid.position.z);
+    t.push_back(asteroid.t);
+    velocity.push_back(asteroid.velocity);
+    scale.push_back(asteroid.scale);
+    rx.push_back(asteroid.rotation.x);
+    ry.push_back(asteroid.rotation.y);
+    rz.push_back(asteroid.rotation.z);
+
+    const Trajectory& tr = asteroid.trajectory;
+    ax.push_back(tr.a.x); ay.push_back(tr.a.y); az.push_back(tr.a.z);
+    bx.push_back(tr.b.x); by.push_back(tr.b.y); bz.push_back(tr.b.z);
+    cx.push_back(tr.c.x); cy.push_back(tr.c.y); cz.push_back(tr.c.z);
+    dx.push_back(tr.d.x); dy.push_back(tr.d.y); dz.push_back(tr.d.z);
+
+    return handles.add();
+}
+
+Trajectory AsteroidField::trajectory(size_t i) const
+{
+    return Trajectory(glm::vec3(ax[i], ay[i], az[i]),
+                      glm::vec3(bx[i], by[i], bz[i]),
+                      glm::vec3(cx[i], cy[i], cz[i]),
+                      glm::vec3(dx[i], dy[i], dz[i]));
+}
+
+glm::vec4 AsteroidField::linearVelocity(size_t i) const
+{
+    // t avança "velocity" unidades por segundo
+    return trajectory(i).velocity(t[i]) * velocity[i];
+}
+
+glm::vec4 AsteroidField::predictPosition(size_t i, float deltaTime) const
+{
+    return trajectory(i).position(t[i] + velocity[i] * deltaTime);
+}
+
+void AsteroidField::sweptBounds(size_t i, float deltaTime, glm::vec3& bbox_min, glm::vec3& bbox_max) const
+{
+    trajectory(i).bounds(t[i], t[i] + velocity[i] * deltaTime, bbox_min, bbox_max);
+}
+
+void AsteroidField::remove(size_t i)
+{
+    size_t last = size() - 1;
+    for (int c = 0; c < NUM_COLUMNS; c++) {
+        std::vector<float>& column = *columns[c];
+        column[i] = column[last];
+        column.pop_back();
+    }
+    handles.removeAt(i);
+}
+
+void AsteroidField::flush()
+{
+    const std::vector<EntityHandle>& pending = handles.pending();
+    for (size_t p = 0; p < pending.size(); p++) {
+        if (handles.valid(pending[p]))
+            remove(handles.indexOf(pending[p]));
+    }
+    handles.clearPending();
+}
+
+void AsteroidField::clear()
+{
+    for (int c = 0; c < NUM_COLUMNS; c++)
+        columns[c]->clear();
+    handles.clear();
+}
+
+void AsteroidField::reserve(size_t n)
+{
+    for (int c = 0; c < NUM_COLUMNS; c++)
+        columns[c]->reserve(n);
+}
+
+// Horner: ((a*t + b)*t + c)*t + d, mesma fórmula de Trajectory::position
+void AsteroidField::computeNewPositionsScalar(size_t begin, size_t end, float deltaTime)
+{
+    for (size_t i = begin; i < end; i++) {
+        float s = t[i] + velocity[i] * deltaTime;
+        t[i] = s;
+        px[i] = ((ax[i] * s + bx[i]) * s + cx[i]) * s + dx[i];
+        py[i] = ((ay[i] * s + by[i]) * s + cy[i]) * s + dy[i];
+        pz[i] = ((az[i] * s + bz[i]) * s + cz[i]) * s + dz[i];
+    }
+}
+
+#ifdef ASTEROIDFIELD_X86
+
+// Avalia 4 asteroides por vez, a partir de begin. Retorna onde parou; o
+// restante fica para o laço escalar.
+__attribute__((target("sse")))
+size_t AsteroidField::computeNewPositionsSSE(size_t begin, size_t end, float deltaTime)
+{
+    const size_t n = begin + ((end - begin) & ~size_t(3));
+    const __m128 dt = _mm_set1_ps(deltaTime);
+
+    for (size_t i = begin; i < n; i += 4) {
+        __m128 s = _mm_add_ps(_mm_loadu_ps(&t[i]), _mm_mul_ps(_mm_loadu_ps(&velocity[i]), dt));
+        _mm_storeu_ps(&t[i], s);
+
+        #define HORNER_SSE(out, a, b, c, d) \
+            _mm_storeu_ps(&out[i], _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps( \
+                _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&a[i]), s), _mm_loadu_ps(&b[i])), s), \
+                _mm_loadu_ps(&c[i])), s), _mm_loadu_ps(&d[i])))
+        HORNER_SSE(px, ax, bx, cx, dx);
+        HORNER_SSE(py, ay, by, cy, dy);
+        HORNER_SSE(pz, az, bz, cz, dz);
+        #undef HORNER_SSE
+    }
+    return n;
+}
+
+// Avalia 8 asteroides por vez. Compilada com suporte a AVX mesmo sem -mavx;
+// só é chamada se a CPU suportar (veja computeNewPositions()).
+__attribute__((target("avx")))
+size_t AsteroidField::computeNewPositionsAVX(size_t begin, size_t end, float deltaTime)
+{
+    const size_t n = begin + ((end - begin) & ~size_t(7));
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+
+    for (size_t i = begin; i < n; i += 8) {
+        __m256 s = _mm256_add_ps(_mm256_loadu_ps(&t[i]), _mm256_mul_ps(_mm256_loadu_ps(&velocity[i]), dt));
+        _mm256_storeu_ps(&t[i], s);
+
+        #define HORNER_AVX(out, a, b, c, d) \
+            _mm256_storeu_ps(&out[i], _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps( \
+                _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&a[i]), s), _mm256_loadu_ps(&b[i])), s), \
+                _mm256_loadu_ps(&c[i])), s), _mm256_loadu_ps(&d[i])))
+        HORNER_AVX(px, ax, bx, cx, dx);
+        HORNER_AVX(py, ay, by, cy, dy);
+        HORNER_AVX(pz, az, bz, cz, dz);
+        #undef HORNER_AVX
+    }
+    return n;
+}
+
+#else
+
+size_t AsteroidField::computeNewPositionsSSE(size_t begin, size_t end, float deltaTime) { return begin; }
+size_t AsteroidField::computeNewPositionsAVX(size_t begin, size_t end, float deltaTime) { return begin; }
+
+#endif // ASTEROIDFIELD_X86
+
+void AsteroidField::computeNewPositions(float deltaTime)
+{
+    computeNewPositions(deltaTime, 0, size());
+}
+
+void AsteroidField::computeNewPositions(float deltaTime, size_t begin, size_t end)
+{
+    size_t done = begin;
+#ifdef ASTEROIDFIELD_X86
+    static const bool has_avx = __builtin_cpu_supports("avx");
+    done = has_avx ? computeNewPositionsAVX(begin, end, deltaTime) : computeNewPositionsSSE(begin, end, deltaTime);
+#endif
+    computeNewPositionsScalar(done, end, deltaTime);
+}
@@ -0,0 +1,47 @@
+#include "BulletPool.h"
+
+#include <math.h>
+
+BulletPool::BulletPool(size_t capacity, float range)
+    : range(range), tail(0), count(0)
+{
+    size_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+    items.resize(size);
+    mask = size - 1;
+}
+
+BulletPool::~BulletPool()
+{
+    //dtor
+}
+
+void BulletPool::add(const bullet& b, float time)
+{
+    if (count == items.size()) {
+        tail = (tail + 1) & mask;
+        count--;
+    }
+
+    bullet& slot = items[(tail + count) & mask];
+    slot = b;
+    slot.spawn_time = time;
+    float speed = sqrtf(b.direction.x*b.direction.x + b.direction.y*b.direction.y + b.direction.z*b.direction.z);
+    slot.expire_time = speed > 0.0f ? time + range / speed : time;
+    count++;
+}
+
+void BulletPool::retire(float time)
+{
+    while (count > 0 && items[tail].expire_time <= time) {
+        tail = (tail + 1) & mask;
+        count--;
+    }
+}
+
+void BulletPool::clear()
+{
+    tail = 0;
+    count = 0;
+}
@@ -0,0 +1,206 @@
+#include "CollisionMesh.h"
+
+#include <algorithm>
+#include <map>
+#include <math.h>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#define BVH_LEAF_TRIANGLES 4
+#define BVH_MAX_DEPTH 32
+
+namespace
+{
+    // Ponto do triângulo abc mais próximo de p (Ericson, Real-Time Collision
+    // Detection, 5.1.5)
+    glm::vec3 closestPointOnTriangle(glm::vec3 p, glm::vec3 a, glm::vec3 b, glm::vec3 c)
+    {
+        glm::vec3 ab = b - a;
+        glm::vec3 ac = c - a;
+        glm::vec3 ap = p - a;
+        float d1 = glm::dot(ab, ap);
+        float d2 = glm::dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f)
+            return a;
+
+        glm::vec3 bp = p - b;
+        float d3 = glm::dot(ab, bp);
+        float d4 = glm::dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3)
+            return b;
+
+        float vc = d1*d4 - d3*d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+            return a + ab * (d1 / (d1 - d3));
+
+        glm::vec3 cp = p - c;
+        float d5 = glm::dot(ab, cp);
+        float d6 = glm::dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6)
+            return c;
+
+        float vb = d5*d2 - d1*d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+            return a + ac * (d2 / (d2 - d6));
+
+        float va = d3*d6 - d5*d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+            return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+        float denom = 1.0f / (va + vb + vc);
+        return a + ab * (vb * denom) + ac * (vc * denom);
+    }
+
+    // Distância ao quadrado entre p e a AABB (0 se p está dentro)
+    float distance2ToBox(glm::vec3 p, glm::vec3 bbox_min, glm::vec3 bbox_max)
+    {
+        glm::vec3 d = glm::max(glm::max(bbox_min - p, p - bbox_max), glm::vec3(0.0f));
+        return glm::dot(d, d);
+    }
+
+    struct VertexLess
+    {
+        bool operator()(const glm::vec3& a, const glm::vec3& b) const
+        {
+            if (a.x != b.x) return a.x < b.x;
+            if (a.y != b.y) return a.y < b.y;
+            return a.z < b.z;
+        }
+    };
+}
+
+CollisionMesh::CollisionMesh()
+    : radius(0.0f)
+{
+    //ctor
+}
+
+CollisionMesh::~CollisionMesh()
+{
+    //dtor
+}
+
+void CollisionMesh::build(const std::vector<glm::vec4>& triangles)
+{
+    positions.clear();
+    indices.clear();
+    nodes.clear();
+    radius = 0.0f;
+
+    // 1) une vértices idênticos (os modelos OBJ repetem um vértice por
+    //    triângulo) e descarta triângulos degenerados
+    std::map<glm::vec3, uint32_t, VertexLess> unique;
+    std::vector<uint32_t> soup;
+    for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+        uint32_t tri[3];
+        for (int k = 0; k < 3; k++) {
+            glm::vec3 v(triangles[i+k].x, triangles[i+k].y, triangles[i+k].z);
+            std::map<glm::vec3, uint32_t, VertexLess>::iterator it = unique.find(v);
+            if (it == unique.end()) {
+                it = unique.insert(std::make_pair(v, (uint32_t)positions.size())).first;
+                positions.push_back(v);
+                radius = std::max(radius, glm::length(v));
+            }
+            tri[k] = it->second;
+        }
+        if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2])
+            continue;
+        soup.insert(soup.end(), tri, tri + 3);
+    }
+
+    size_t count = soup.size() / 3;
+    if (count == 0)
+        return;
+
+    // 2) BVH sobre os centróides dos triângulos
+    std::vector<uint32_t> order(count);
+    std::vector<glm::vec3> centroids(count);
+    for (size_t t = 0; t < count; t++) {
+        order[t] = t;
+        centroids[t] = (positions[soup[3*t]] + positions[soup[3*t+1]] + positions[soup[3*t+2]]) / 3.0f;
+    }
+    indices.swap(soup);
+    buildNode(order, centroids, 0, count, 0);
+
+    // 3) triângulos reordenados para que cada folha seja um intervalo contínuo
+    std::vector<uint32_t> sorted(indices.size());
+    for (size_t t = 0; t < count; t++)
+        for (int k = 0; k < 3; k++)
+            sorted[3*t + k] = indices[3*order[t] + k];
+    indices.swap(sorted);
+}
+
+uint32_t CollisionMesh::buildNode(std::vector<uint32_t>& order, std::vector<glm::vec3>& centroids, uint32_t begin, uint32_t end, int depth)
+{
+    uint32_t index = nodes.size();
+    nodes.push_back(Node());
+
+    glm::vec3 bbox_min = positions[indices[3*order[begin]]];
+    glm::vec3 bbox_max = bbox_min;
+    glm::vec3 centroid_min = centroids[order[begin]];
+    glm::vec3 centroid_max = centroid_min;
+    for (uint32_t t = begin; t < end; t++) {
+        for (int k = 0; k < 3; k++) {
+            bbox_min = glm::min(bbox_min, positions[indices[3*order[t] + k]]);
+            bbox_max = glm::max(bbox_max, positions[indices[3*order[t] + k]]);
+        }
+        centroid_min = glm::min(centroid_min, centroids[order[t]]);
+        centroid_max = glm::max(centroid_max, centroids[order[t]]);
+    }
+    nodes[index].bbox_min = bbox_min;
+    nodes[index].bbox_max = bbox_max;
+
+    if (end - begin <= BVH_LEAF_TRIANGLES || depth >= BVH_MAX_DEPTH) {
+        nodes[index].first = begin;
+        nodes[index].count = end - begin;
+        return index;
+    }
+
+    // divide pela mediana no eixo mais longo dos centróides
+    glm::vec3 extent = centroid_max - centroid_min;
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+    uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                     [&centroids, axis](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+    buildNode(order, centroids, begin, middle, depth + 1);
+    uint32_t right = buildNode(order, centroids, middle, end, depth + 1);
+    nodes[index].first = right;
+    nodes[index].count = 0;
+    return index;
+}
+
+bool CollisionMesh::intersectsSphere(glm::vec3 center, float sphere_radius) const
+{
+    if (nodes.empty())
+        return false;
+
+    float radius2 = sphere_radius * sphere_radius;
+    uint32_t stack[BVH_MAX_DEPTH + 2];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (distance2ToBox(center, node.bbox_min, node.bbox_max) > radius2)
+            continue;
+
+        if (node.count == 0) {
+            stack[top++] = node.first;
+            stack[top++] = &node - &nodes[0] + 1;
+            continue;
+        }
+
+        for (uint32_t t = node.first; t < node.first + node.count; t++) {
+            glm::vec3 closest = closestPointOnTriangle(center,
+                                                       positions[indices[3*t]],
+                                                       positions[indices[3*t + 1]],
+                                                       positions[indices[3*t + 2]]);
+            glm::vec3 d = closest - center;
+            if (glm::dot(d, d) <= radius2)
+                return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,34 @@
+#include "FrameUniforms.h"
+
+#include <stdio.h>
+
+FrameUniforms::FrameUniforms()
+{
+    glGenBuffers(1, &buffer_id);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer_id);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformData), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, buffer_id);
+}
+
+FrameUniforms::~FrameUniforms()
+{
+    glDeleteBuffers(1, &buffer_id);
+}
+
+void FrameUniforms::attach(GLuint program) const
+{
+    GLuint block = glGetUniformBlockIndex(program, "FrameUniforms");
+    if (block == GL_INVALID_INDEX) {
+        fprintf(stderr, "ERROR: programa %u não tem o bloco \"FrameUniforms\".\n", program);
+        return;
+    }
+    glUniformBlockBinding(program, block, FRAME_UNIFORMS_BINDING);
+}
+
+void FrameUniforms::update(const FrameUniformData& data)
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer_id);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniformData), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,157 @@
+#include "Frustum.h"
+
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FRUSTUM_X86
+#include <immintrin.h>
+#endif
+
+Frustum::Frustum()
+{
+    for (int p = 0; p < NUM_PLANES; p++)
+        planes[p] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); // tudo visível
+}
+
+Frustum::Frustum(const glm::mat4& clip)
+{
+    extract(clip);
+}
+
+// Um ponto está dentro do volume se -w <= x, y, z <= w em coordenadas de
+// recorte, e cada uma dessas desigualdades é um plano no mundo: a linha 3
+// da matriz mais ou menos as linhas 0, 1 e 2. A glm guarda as matrizes por
+// coluna, então a linha i é (m[0][i], m[1][i], m[2][i], m[3][i]).
+void Frustum::extract(const glm::mat4& clip)
+{
+    for (int i = 0; i < 3; i++) {
+        glm::vec4 row(clip[0][i], clip[1][i], clip[2][i], clip[3][i]);
+        glm::vec4 w(clip[0][3], clip[1][3], clip[2][3], clip[3][3]);
+        planes[2*i]     = w + row;
+        planes[2*i + 1] = w - row;
+    }
+    for (int p = 0; p < NUM_PLANES; p++) {
+        glm::vec4& plane = planes[p];
+        float length = sqrtf(plane.x*plane.x + plane.y*plane.y + plane.z*plane.z);
+        if (length > 0.0f)
+            plane /= length;
+    }
+}
+
+bool Frustum::intersectsSphere(glm::vec3 center, float radius) const
+{
+    for (int p = 0; p < NUM_PLANES; p++) {
+        const glm::vec4& plane = planes[p];
+        if (plane.x*center.x + plane.y*center.y + plane.z*center.z + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+namespace
+{
+    size_t cullScalar(const glm::vec4* planes, const float* x, const float* y, const float* z,
+                      const float* radius, float radius_scale, size_t begin, size_t end, uint8_t* visible)
+    {
+        size_t count = 0;
+        for (size_t i = begin; i < end; i++) {
+            float r = radius[i] * radius_scale;
+            uint8_t inside = 1;
+            for (int p = 0; p < Frustum::NUM_PLANES; p++) {
+                if (planes[p].x*x[i] + planes[p].y*y[i] + planes[p].z*z[i] + planes[p].w < -r) {
+                    inside = 0;
+                    break;
+                }
+            }
+            visible[i] = inside;
+            count += inside;
+        }
+        return count;
+    }
+
+#ifdef FRUSTUM_X86
+
+    // 4 esferas por vez; retorna quantas foram processadas, o restante fica
+    // para o laço escalar
+    __attribute__((target("sse")))
+    size_t cullSSE(const glm::vec4* planes, const float* x, const float* y, const float* z,
+                   const float* radius, float radius_scale, size_t n, uint8_t* visible, size_t& count)
+    {
+        const size_t end = n & ~size_t(3);
+        const __m128 scale = _mm_set1_ps(radius_scale);
+        const __m128 zero = _mm_setzero_ps();
+
+        for (size_t i = 0; i < end; i += 4) {
+            __m128 px = _mm_loadu_ps(&x[i]);
+            __m128 py = _mm_loadu_ps(&y[i]);
+            __m128 pz = _mm_loadu_ps(&z[i]);
+            __m128 r = _mm_mul_ps(_mm_loadu_ps(&radius[i]), scale);
+            __m128 inside = _mm_cmpeq_ps(zero, zero);
+            for (int p = 0; p < Frustum::NUM_PLANES; p++) {
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].x), px),
+                                                 _mm_mul_ps(_mm_set1_ps(planes[p].y), py)),
+                                      _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].z), pz),
+                                                 _mm_add_ps(_mm_set1_ps(planes[p].w), r)));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+                if (_mm_movemask_ps(inside) == 0)
+                    break;
+            }
+            int mask = _mm_movemask_ps(inside);
+            for (int lane = 0; lane < 4; lane++) {
+                visible[i + lane] = (mask >> lane) & 1;
+                count += (mask >> lane) & 1;
+            }
+        }
+        return end;
+    }
+
+    // 8 esferas por vez. Compilada com suporte a AVX mesmo sem -mavx; só é
+    // chamada se a CPU suportar (veja cullSpheres()).
+    __attribute__((target("avx")))
+    size_t cullAVX(const glm::vec4* planes, const float* x, const float* y, const float* z,
+                   const float* radius, float radius_scale, size_t n, uint8_t* visible, size_t& count)
+    {
+        const size_t end = n & ~size_t(7);
+        const __m256 scale = _mm256_set1_ps(radius_scale);
+        const __m256 zero = _mm256_setzero_ps();
+
+        for (size_t i = 0; i < end; i += 8) {
+            __m256 px = _mm256_loadu_ps(&x[i]);
+            __m256 py = _mm256_loadu_ps(&y[i]);
+            __m256 pz = _mm256_loadu_ps(&z[i]);
+            __m256 r = _mm256_mul_ps(_mm256_loadu_ps(&radius[i]), scale);
+            __m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+            for (int p = 0; p < Frustum::NUM_PLANES; p++) {
+                __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[p].x), px),
+                                                       _mm256_mul_ps(_mm256_set1_ps(planes[p].y), py)),
+                                         _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[p].z), pz),
+                                                       _mm256_add_ps(_mm256_set1_ps(planes[p].w), r)));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, zero, _CMP_GE_OQ));
+                if (_mm256_movemask_ps(inside) == 0)
+                    break;
+            }
+            int mask = _mm256_movemask_ps(inside);
+            for (int lane = 0; lane < 8; lane++) {
+                visible[i + lane] = (mask >> lane) & 1;
+                count += (mask >> lane) & 1;
+            }
+        }
+        return end;
+    }
+
+#endif // FRUSTUM_X86
+}
+
+size_t Frustum::cullSpheres(const float* x, const float* y, const float* z,
+                            const float* radius, float radius_scale,
+                            size_t n, uint8_t* visible) const
+{
+    size_t count = 0;
+    size_t done = 0;
+#ifdef FRUSTUM_X86
+    static const bool has_avx = __builtin_cpu_supports("avx");
+    done = has_avx ? cullAVX(planes, x, y, z, radius, radius_scale, n, visible, count)
+                   : cullSSE(planes, x, y, z, radius, radius_scale, n, visible, count);
+#endif
+    return count + cullScalar(planes, x, y, z, radius, radius_scale, done, n, visible);
+}
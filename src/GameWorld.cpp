@@ -0,0 +1,309 @@
+#include "GameWorld.h"
+
+#include <iostream>
+#include <algorithm>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include "matrices.h"
+
+GameWorld::GameWorld(unsigned int seed, unsigned int threads)
+    : bullets(BULLET_POOL_CAPACITY, ASTEROIDS_DESTROY_DISTANCE),
+      jobs(threads),
+      grid(BROADPHASE_CELL_SIZE)
+{
+    rng.seed(seed);
+    spaceshipModel = Matrix_Identity();
+    spaceshipInverseModel = Matrix_Identity();
+}
+
+GameWorld::~GameWorld()
+{
+    //dtor
+}
+
+void GameWorld::setSpaceshipMesh(const std::vector<glm::vec4>& triangles)
+{
+    spaceshipMesh.build(triangles);
+}
+
+bool GameWorld::isGameOver()
+{
+    return spaceship.life <= 0;
+}
+
+// Avança a simulação em deltaTime segundos
+void GameWorld::step(float deltaTime)
+{
+    // Actions
+    if (input.left)
+        spaceship.bendLeft(deltaTime);
+    if (input.right)
+        spaceship.bendRight(deltaTime);
+    if (input.up)
+        spaceship.speedUp(deltaTime);
+    if (input.down)
+        spaceship.brake(deltaTime);
+    if (input.shoot) {
+        bullets.add(spaceship.shoot(), time);
+        input.shoot = false;
+    }
+
+    // asteroids logic
+    if (asteroids.size() < maxAsteroids) {
+        asteroids.add(generateNewAsteroid());
+    }
+
+    removeFarObjects();
+
+    /////////////////////////////
+    // New objects new positions
+    jobs.parallelFor(0, asteroids.size(), JOB_ASTEROIDS_PER_TASK, [this, deltaTime](size_t begin, size_t end) {
+        asteroids.computeNewPositions(deltaTime, begin, end);
+    });
+
+    glm::vec4 new_position = spaceship.computeNewPosition(deltaTime);
+    spaceshipModel = Matrix_Translate(new_position.x, new_position.y, new_position.z)
+                   * Matrix_Rotate_X(spaceship.phi)
+                   * Matrix_Rotate_Y(spaceship.theta)
+                   * Matrix_Scale(spaceship.scale, spaceship.scale, spaceship.scale);
+    spaceshipInverseModel = Matrix_Scale(1/spaceship.scale, 1/spaceship.scale, 1/spaceship.scale)
+                          * Matrix_Rotate_Y(-spaceship.theta)
+                          * Matrix_Rotate_X(-spaceship.phi)
+                          * Matrix_Translate(-new_position.x, -new_position.y, -new_position.z);
+
+    testCollisions(deltaTime);
+
+    // Destruições marcadas durante o tick são aplicadas de uma só vez
+    asteroids.flush();
+
+    time += deltaTime;
+    ticks++;
+}
+
+void GameWorld::removeFarObjects()
+{
+    // remove asteroid very far: as distâncias são calculadas em paralelo e
+    // as remoções marcadas em ordem de índice
+    const float max_distance2 = ASTEROIDS_DESTROY_DISTANCE * ASTEROIDS_DESTROY_DISTANCE;
+    const glm::vec4 ship = spaceship.position;
+    farAsteroid.resize(asteroids.size());
+    jobs.parallelFor(0, asteroids.size(), JOB_ASTEROIDS_PER_TASK, [this, ship, max_distance2](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            float dx = asteroids.px[i] - ship.x;
+            float dy = asteroids.py[i] - ship.y;
+            float dz = asteroids.pz[i] - ship.z;
+            farAsteroid[i] = dx*dx + dy*dy + dz*dz >= max_distance2;
+        }
+    });
+    for (size_t i = 0; i < asteroids.size(); i++) {
+        if (farAsteroid[i])
+            asteroids.destroyLater(i);
+    }
+    // remove bullet very far (out of range since it was shot)
+    bullets.retire(time);
+}
+
+void GameWorld::testCollisions(float deltaTime)
+{
+    size_t n = asteroids.size();
+    hitSpaceship.assign(n, 0);
+    hitAsteroid.assign(n, 0);
+    hitBullet.assign(n, 0);
+
+    // 1) broadphase: AABB do volume varrido por cada asteroide vivo durante
+    //    o tick (o trecho da curva que acabou de percorrer), para que um
+    //    asteroide rápido não atravesse outro objeto entre dois ticks. Quem
+    //    já está marcado (longe demais) não participa de nenhum teste.
+    grid.clear();
+    asteroidSpheres.clear();
+    previousPosition.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        if (asteroids.isDying(i))
+            continue;
+        float r = (1/asteroids.scale[i]) * 0.04;
+        glm::vec3 c(asteroids.px[i], asteroids.py[i], asteroids.pz[i]);
+        glm::vec3 bbox_min, bbox_max;
+        asteroids.sweptBounds(i, -deltaTime, bbox_min, bbox_max);
+        grid.insert(i, bbox_min - glm::vec3(r), bbox_max + glm::vec3(r));
+        previousPosition[i] = glm::vec3(asteroids.predictPosition(i, -deltaTime));
+        asteroidSpheres.add(i, c, r);
+    }
+    grid.build();
+
+    // 2) narrowphase só nos candidatos: nave, pares de asteroides e tiros
+    //    são independentes e rodam como jobs separados
+    JobCounter narrowphase;
+    jobs.run([this] { testSpaceship(); }, narrowphase);
+    jobs.run([this] { testAsteroidPairs(); }, narrowphase);
+    testBullets(time + deltaTime);
+    jobs.wait(narrowphase);
+
+    // 3) resolução em ordem de índice, com a mesma prioridade de antes:
+    //    nave, outro asteroide, tiro (só o tiro pontua)
+    for (size_t i = 0; i < n; i++) {
+        if (!hitSpaceship[i] && !hitAsteroid[i] && !hitBullet[i])
+            continue;
+        if (hitSpaceship[i])
+            spaceship.life--;
+        else if (!hitAsteroid[i])
+            player.score += 100;
+        asteroids.destroyLater(i);
+    }
+}
+
+void GameWorld::testSpaceship()
+{
+    float spaceship_radius = spaceshipMesh.boundingRadius() * spaceship.scale;
+    glm::vec3 ship(spaceship.position.x, spaceship.position.y, spaceship.position.z);
+    grid.query(ship - glm::vec3(spaceship_radius), ship + glm::vec3(spaceship_radius), candidates);
+    for (size_t k = 0; k < candidates.size(); k++) {
+        collisionStats.spaceshipCandidates++;
+        if (testInterseption(candidates[k], spaceship, spaceshipInverseModel)) {
+            collisionStats.spaceshipHits++;
+            hitSpaceship[candidates[k]] = 1;
+        }
+    }
+}
+
+void GameWorld::testAsteroidPairs()
+{
+    grid.findPairs(candidatePairs);
+    pairHit.resize(candidatePairs.size());
+    jobs.parallelFor(0, candidatePairs.size(), JOB_PAIRS_PER_TASK, [this](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++)
+            pairHit[k] = testInterseption(candidatePairs[k].first, candidatePairs[k].second);
+    });
+
+    collisionStats.asteroidCandidates += candidatePairs.size();
+    for (size_t k = 0; k < candidatePairs.size(); k++) {
+        if (pairHit[k]) {
+            collisionStats.asteroidHits++;
+            // como antes, quem é destruído pelo par é o de menor índice
+            hitAsteroid[candidatePairs[k].first] = 1;
+        }
+    }
+}
+
+void GameWorld::testBullets(float now)
+{
+    // rastro de cada tiro, do disparo até a posição no instante "now"
+    bulletRays.clear();
+    for (size_t j = 0; j < bullets.size(); j++) {
+        const bullet& b = bullets[j];
+        bulletRays.add(j, glm::vec3(b.start_position.x, b.start_position.y, b.start_position.z),
+                       glm::vec3(b.direction.x, b.direction.y, b.direction.z), b.age(now));
+    }
+
+    // campo pequeno: todos contra todos, 8 asteroides por instrução, é mais
+    // barato que percorrer a grade. Campo grande: só os asteroides nas
+    // células que o rastro atravessa.
+    bool brute_force = bulletRays.size() * asteroidSpheres.size() <= BULLET_BATCH_MAX_PAIRS;
+    size_t tasks = (bulletRays.size() + JOB_BULLETS_PER_TASK - 1) / JOB_BULLETS_PER_TASK;
+    if (bulletTasks.size() < tasks)
+        bulletTasks.resize(tasks);
+
+    jobs.parallelFor(0, bulletRays.size(), JOB_BULLETS_PER_TASK, [this, brute_force](size_t begin, size_t end) {
+        BulletTask& task = bulletTasks[begin / JOB_BULLETS_PER_TASK];
+        task.hits.clear();
+        task.tested = 0;
+        for (size_t k = begin; k < end; k++) {
+            if (brute_force) {
+                task.tested += asteroidSpheres.size();
+                intersectRay(bulletRays, k, asteroidSpheres, task.hits);
+                continue;
+            }
+            glm::vec3 p0(bulletRays.ox[k], bulletRays.oy[k], bulletRays.oz[k]);
+            glm::vec3 d(bulletRays.dx[k], bulletRays.dy[k], bulletRays.dz[k]);
+            grid.querySegment(p0, p0 + d * bulletRays.tmax[k], task.candidates);
+            task.spheres.clear();
+            for (size_t c = 0; c < task.candidates.size(); c++) {
+                uint32_t i = task.candidates[c];
+                task.spheres.add(i, glm::vec3(asteroids.px[i], asteroids.py[i], asteroids.pz[i]),
+                                 (1/asteroids.scale[i]) * 0.04);
+            }
+            task.tested += task.spheres.size();
+            intersectRay(bulletRays, k, task.spheres, task.hits);
+        }
+    });
+
+    for (size_t t = 0; t < tasks; t++) {
+        const BulletTask& task = bulletTasks[t];
+        collisionStats.bulletCandidates += task.tested;
+        collisionStats.bulletHits += task.hits.size();
+        for (size_t h = 0; h < task.hits.size(); h++)
+            hitBullet[task.hits[h].sphere] = 1;
+    }
+}
+
+float GameWorld::randomFloat(float min, float max)
+{
+    return min + static_cast<float>(rng()) / (static_cast<float>(rng.max() / (max - min)));
+}
+
+// gerar os asteroides em um raio maximo com relação a nave
+// e garantir que eles venha em direção a nave
+Asteroid GameWorld::generateNewAsteroid() {
+    // converter para coordenadas esfericas
+    glm::vec4 c = spaceship.position;
+    glm::vec4 displacement = c - glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+    float rho = ASTEROIDS_SPAWN_DISTANCE;
+    float phi = randomFloat(PHI_MIN, PHI_MAX);
+    float theta = randomFloat(THETA_MIN, THETA_MAX);
+    float anti_theta = theta > 0 ? theta - PI : theta + PI;
+    float anti_phi = -phi;
+
+    glm::vec4 start_position = toCartesianFromSpherical(rho, theta, phi) + displacement;
+    glm::vec4 end_position = toCartesianFromSpherical(rho, anti_theta, anti_phi) + displacement;
+
+    float phi_gap = PI/4;
+    float rho2 = 3 * ASTEROIDS_SPAWN_DISTANCE / 2;
+    float theta2 = randomFloat(THETA_MIN, THETA_MAX);
+    float phi2 = phi > 0 ? phi - phi_gap : phi + phi_gap;
+    float anti_theta2 = theta2 > 0 ? theta2 - PI : theta2 + PI;
+    float anti_phi2 = -phi2;
+
+    glm::vec4 start_middle_position = toCartesianFromSpherical(rho2, theta2, phi2) + displacement;
+    glm::vec4 end_middle_position = toCartesianFromSpherical(rho2, anti_theta2, anti_phi2) + displacement;
+
+    // pontos de controle convertidos uma única vez para a base de potências
+    Trajectory trajectory = Trajectory::fromBezier(start_position,
+                                                   start_middle_position,
+                                                   end_middle_position,
+                                                   end_position);
+    Asteroid newAsteroid(start_position, trajectory);
+
+    return newAsteroid;
+}
+
+// teste esfera-triangulo, no espaço do modelo da nave: só o centro do
+// asteroide é transformado, e a BVH de spaceshipMesh descarta os triângulos
+// distantes
+// Conservador: a esfera do asteroide é trocada pela esfera que envolve todo
+// o trecho percorrido no tick (centro no meio do trecho)
+bool GameWorld::testInterseption(size_t asteroid, const Spaceship& spaceship, const glm::mat4& inverse_model) {
+    glm::vec3 p1(asteroids.px[asteroid], asteroids.py[asteroid], asteroids.pz[asteroid]);
+    glm::vec3 p0 = previousPosition[asteroid];
+    glm::vec3 middle = (p0 + p1) * 0.5f;
+    glm::vec4 local = matrixVectorProduct(inverse_model, glm::vec4(middle, 1.0f));
+    float sphere_radius = (1/asteroids.scale[asteroid]) * 0.04 + glm::length(p1 - p0) * 0.5f;
+    return spaceshipMesh.intersectsSphere(glm::vec3(local.x, local.y, local.z), sphere_radius / spaceship.scale);
+}
+
+// teste esfera-esfera varrido: cada centro anda em linha reta da posição do
+// tick anterior até a atual, e vale a menor distância entre eles no tick
+bool GameWorld::testInterseption(size_t asteroid1, size_t asteroid2) {
+    float C = 0.04;
+    float r1 = (1/asteroids.scale[asteroid1]) * C;
+    float r2 = (1/asteroids.scale[asteroid2]) * C;
+    glm::vec3 d0 = previousPosition[asteroid1] - previousPosition[asteroid2];
+    glm::vec3 d1 = glm::vec3(asteroids.position(asteroid1) - asteroids.position(asteroid2));
+    glm::vec3 motion = d1 - d0;
+    float s = 0.0f;
+    float motion2 = glm::dot(motion, motion);
+    if (motion2 > 1e-12f)
+        s = std::min(1.0f, std::max(0.0f, -glm::dot(d0, motion) / motion2));
+    float distance = glm::length(d0 + motion * s);
+    return (r1 + r2) > distance;
+}
@@ -0,0 +1,157 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Qual JobSystem e qual fila pertencem à thread atual
+    thread_local const JobSystem* t_system = nullptr;
+    thread_local unsigned int t_worker = 0;
+}
+
+JobSystem::JobSystem(unsigned int threads)
+    : queued(0), stopping(false)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned int i = 0; i < threads; i++)
+        workers.push_back(new Worker());
+
+    // a thread 0 é a que criou o JobSystem
+    t_system = this;
+    t_worker = 0;
+    for (unsigned int i = 1; i < threads; i++)
+        workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    // Todas as threads terminam antes de apagar qualquer fila: uma thread
+    // ainda acordando pode tentar roubar de outra
+    for (size_t i = 0; i < workers.size(); i++) {
+        if (workers[i]->thread.joinable())
+            workers[i]->thread.join();
+    }
+    for (size_t i = 0; i < workers.size(); i++)
+        delete workers[i];
+}
+
+unsigned int JobSystem::currentWorker() const
+{
+    // Threads de fora (nem a criadora nem as do pool) usam a fila 0
+    return t_system == this ? t_worker : 0;
+}
+
+void JobSystem::run(const Job& job, JobCounter& counter)
+{
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    if (workers.size() == 1) {
+        job();
+        counter.pending.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    Task task;
+    task.job = job;
+    task.counter = &counter;
+    Worker* worker = workers[currentWorker()];
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->tasks.push_back(task);
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued.fetch_add(1, std::memory_order_relaxed);
+    }
+    wake.notify_one();
+}
+
+// O dono trabalha no fim da própria fila (o job mais recente, cujos dados
+// ainda estão no cache)
+bool JobSystem::pop(unsigned int self, Task& task)
+{
+    Worker* worker = workers[self];
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    if (worker->tasks.empty())
+        return false;
+    task = worker->tasks.back();
+    worker->tasks.pop_back();
+    return true;
+}
+
+// Os outros roubam do início (os jobs mais antigos, em geral os maiores)
+bool JobSystem::steal(unsigned int self, Task& task)
+{
+    for (size_t k = 1; k < workers.size(); k++) {
+        Worker* victim = workers[(self + k) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if (victim->tasks.empty())
+            continue;
+        task = victim->tasks.front();
+        victim->tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::runOne(unsigned int self)
+{
+    Task task;
+    if (!pop(self, task) && !steal(self, task))
+        return false;
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    task.job();
+    task.counter->pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    unsigned int self = currentWorker();
+    while (!counter.done()) {
+        if (!runOne(self))
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::workerLoop(unsigned int self)
+{
+    t_system = this;
+    t_worker = self;
+    for (;;) {
+        if (runOne(self))
+            continue;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queued.load(std::memory_order_relaxed) > 0; });
+        if (stopping)
+            return;
+    }
+}
+
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grain, const RangeJob& fn)
+{
+    if (grain == 0)
+        grain = 1;
+    if (end <= begin)
+        return;
+    if (end - begin <= grain || workers.size() == 1) {
+        for (size_t b = begin; b < end; b += grain)
+            fn(b, std::min(b + grain, end));
+        return;
+    }
+
+    // o primeiro bloco fica com quem chamou
+    JobCounter counter;
+    for (size_t b = begin + grain; b < end; b += grain) {
+        size_t e = std::min(b + grain, end);
+        run([&fn, b, e] { fn(b, e); }, counter);
+    }
+    fn(begin, begin + grain);
+    wait(counter);
+}
@@ -0,0 +1,278 @@
+#include "MeshCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Versão da estrutura do arquivo (cabeçalho e tabelas); a dos blocos é o
+// "version" de quem usa
+#define MESH_CACHE_FORMAT 1
+#define MESH_CACHE_ALIGNMENT 16
+
+namespace
+{
+    struct Header
+    {
+        char magic[4];
+        uint32_t format;
+        uint32_t version;
+        uint32_t num_sources;
+        uint32_t num_chunks;
+        uint32_t reserved[3];
+    };
+
+    struct SourceRecord
+    {
+        uint64_t size;
+        int64_t mtime;
+        uint64_t hash;
+    };
+
+    struct ChunkRecord
+    {
+        uint32_t id;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t bytes;
+    };
+
+    const char MAGIC[4] = {'F', 'C', 'G', 'M'};
+
+    bool statFile(const std::string& path, uint64_t* size, int64_t* mtime)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+            return false;
+        *size = (uint64_t)info.st_size;
+        *mtime = (int64_t)info.st_mtime;
+        return true;
+    }
+
+    // FNV-1a de 64 bits do conteúdo do arquivo
+    bool hashFile(const std::string& path, uint64_t* hash)
+    {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == NULL)
+            return false;
+
+        uint64_t h = 14695981039346656037ull;
+        unsigned char buffer[1 << 16];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                h ^= buffer[i];
+                h *= 1099511628211ull;
+            }
+        }
+        fclose(file);
+        *hash = h;
+        return true;
+    }
+
+    size_t alignUp(size_t value)
+    {
+        return (value + MESH_CACHE_ALIGNMENT - 1) & ~(size_t)(MESH_CACHE_ALIGNMENT - 1);
+    }
+}
+
+MeshCacheFile::MeshCacheFile()
+    : data(NULL), size(0)
+#ifdef _WIN32
+    , file(INVALID_HANDLE_VALUE), mapping(NULL)
+#endif
+{
+    //ctor
+}
+
+MeshCacheFile::~MeshCacheFile()
+{
+    close();
+}
+
+bool MeshCacheFile::open(const char* path, const std::vector<std::string>& sources, uint32_t version)
+{
+    close();
+
+#ifdef _WIN32
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < (LONGLONG)sizeof(Header)) {
+        close();
+        return false;
+    }
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        close();
+        return false;
+    }
+    data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+        close();
+        return false;
+    }
+    size = (size_t)file_size.QuadPart;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(Header)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // o mapeamento continua válido
+    if (mapped == MAP_FAILED)
+        return false;
+    data = (const unsigned char*)mapped;
+    size = info.st_size;
+#endif
+
+    const Header* header = (const Header*)data;
+    size_t tables = sizeof(Header) + header->num_sources * sizeof(SourceRecord) + header->num_chunks * sizeof(ChunkRecord);
+    if (std::memcmp(header->magic, MAGIC, 4) != 0 || header->format != MESH_CACHE_FORMAT ||
+        header->version != version || header->num_sources != sources.size() || tables > size) {
+        close();
+        return false;
+    }
+
+    const SourceRecord* records = (const SourceRecord*)(data + sizeof(Header));
+    for (size_t i = 0; i < sources.size(); i++) {
+        uint64_t source_size;
+        int64_t mtime;
+        if (!statFile(sources[i], &source_size, &mtime) || source_size != records[i].size) {
+            close();
+            return false;
+        }
+        if (mtime == records[i].mtime)
+            continue;
+        uint64_t hash;
+        if (!hashFile(sources[i], &hash) || hash != records[i].hash) {
+            close();
+            return false;
+        }
+    }
+
+    const ChunkRecord* chunks = (const ChunkRecord*)(records + header->num_sources);
+    for (uint32_t i = 0; i < header->num_chunks; i++) {
+        if (chunks[i].offset > size || chunks[i].bytes > size - chunks[i].offset) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void MeshCacheFile::close()
+{
+#ifdef _WIN32
+    if (data != NULL)
+        UnmapViewOfFile(data);
+    if (mapping != NULL)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+    mapping = NULL;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (data != NULL)
+        munmap((void*)data, size);
+#endif
+    data = NULL;
+    size = 0;
+}
+
+const void* MeshCacheFile::chunk(uint32_t id, size_t* bytes) const
+{
+    *bytes = 0;
+    if (data == NULL)
+        return NULL;
+
+    const Header* header = (const Header*)data;
+    const ChunkRecord* chunks = (const ChunkRecord*)(data + sizeof(Header) + header->num_sources * sizeof(SourceRecord));
+    for (uint32_t i = 0; i < header->num_chunks; i++) {
+        if (chunks[i].id == id) {
+            *bytes = chunks[i].bytes;
+            return data + chunks[i].offset;
+        }
+    }
+    return NULL;
+}
+
+void MeshCacheWriter::add(uint32_t id, const void* data, size_t bytes)
+{
+    Chunk chunk;
+    chunk.id = id;
+    chunk.data = data;
+    chunk.bytes = bytes;
+    chunks.push_back(chunk);
+}
+
+bool MeshCacheWriter::write(const char* path, const std::vector<std::string>& sources, uint32_t version) const
+{
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, 4);
+    header.format = MESH_CACHE_FORMAT;
+    header.version = version;
+    header.num_sources = sources.size();
+    header.num_chunks = chunks.size();
+
+    std::vector<SourceRecord> records(sources.size());
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (!statFile(sources[i], &records[i].size, &records[i].mtime) || !hashFile(sources[i], &records[i].hash))
+            return false;
+    }
+
+    std::vector<ChunkRecord> table(chunks.size());
+    size_t offset = alignUp(sizeof(Header) + records.size() * sizeof(SourceRecord) + table.size() * sizeof(ChunkRecord));
+    for (size_t i = 0; i < chunks.size(); i++) {
+        std::memset(&table[i], 0, sizeof(ChunkRecord));
+        table[i].id = chunks[i].id;
+        table[i].offset = offset;
+        table[i].bytes = chunks[i].bytes;
+        offset = alignUp(offset + chunks[i].bytes);
+    }
+
+    std::string temporary = std::string(path) + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == NULL)
+        return false;
+
+    const char padding[MESH_CACHE_ALIGNMENT] = {0};
+    size_t written = fwrite(&header, sizeof(header), 1, file) * sizeof(header);
+    if (!records.empty())
+        written += fwrite(&records[0], sizeof(SourceRecord), records.size(), file) * sizeof(SourceRecord);
+    if (!table.empty())
+        written += fwrite(&table[0], sizeof(ChunkRecord), table.size(), file) * sizeof(ChunkRecord);
+    bool ok = true;
+    for (size_t i = 0; i < chunks.size() && ok; i++) {
+        written += fwrite(padding, 1, table[i].offset - written, file);
+        if (chunks[i].bytes > 0)
+            written += fwrite(chunks[i].data, 1, chunks[i].bytes, file);
+        ok = written == table[i].offset + chunks[i].bytes;
+    }
+    ok = fclose(file) == 0 && ok;
+
+    if (ok) {
+#ifdef _WIN32
+        remove(path); // rename() não sobrescreve no Windows
+#endif
+        ok = rename(temporary.c_str(), path) == 0;
+    }
+    if (!ok)
+        remove(temporary.c_str());
+    return ok;
+}
@@ -0,0 +1,374 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Cache FIFO simulado com carimbos de tempo: um vértice está no cache
+    // se foi transformado há no máximo "size" faltas
+    struct FifoCache
+    {
+        std::vector<uint32_t> stamp;
+        uint32_t time;
+        unsigned int size;
+
+        FifoCache(size_t vertex_count, unsigned int size) : stamp(vertex_count, 0), time(size + 1), size(size) {}
+
+        // true se foi uma falta (o vertex shader roda)
+        bool access(uint32_t v)
+        {
+            if (time - stamp[v] > size) {
+                stamp[v] = time++;
+                return true;
+            }
+            return false;
+        }
+
+        void flush() { time += size + 1; }
+    };
+
+    uint32_t hashBytes(const unsigned char* data, size_t length)
+    {
+        // FNV-1a
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < length; i++) {
+            h ^= data[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    // Parâmetros do algoritmo de Forsyth ("Linear-Speed Vertex Cache
+    // Optimisation"), com um cache LRU modelado de 32 entradas
+    const int FORSYTH_CACHE_SIZE = 32;
+    const float FORSYTH_DECAY_POWER = 1.5f;
+    const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+    const float FORSYTH_VALENCE_SCALE = 2.0f;
+    const float FORSYTH_VALENCE_POWER = 0.5f;
+
+    float vertexScore(int cache_position, uint32_t remaining)
+    {
+        if (remaining == 0)
+            return -1.0f; // não faz parte de nenhum triângulo restante
+
+        float score = 0.0f;
+        if (cache_position >= 0) {
+            if (cache_position < 3) {
+                // do último triângulo: valor fixo, para não favorecer tiras
+                score = FORSYTH_LAST_TRIANGLE_SCORE;
+            } else {
+                float scale = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                score = std::pow(1.0f - (cache_position - 3) * scale, FORSYTH_DECAY_POWER);
+            }
+        }
+        // vértices com poucos triângulos restantes devem ser terminados logo
+        score += FORSYTH_VALENCE_SCALE * std::pow((float)remaining, -FORSYTH_VALENCE_POWER);
+        return score;
+    }
+
+    const float* positionOf(const float* positions, size_t stride, uint32_t v)
+    {
+        return (const float*)((const char*)positions + v * stride);
+    }
+}
+
+size_t generateVertexRemap(std::vector<uint32_t>& remap, const void* vertices, size_t vertex_count, size_t stride)
+{
+    const unsigned char* data = (const unsigned char*)vertices;
+    const uint32_t empty = ~0u;
+
+    // tabela aberta com sondagem linear, guardando o primeiro vértice de
+    // cada valor; ocupação <= 50%
+    size_t table_size = 1;
+    while (table_size < 2 * vertex_count)
+        table_size *= 2;
+    std::vector<uint32_t> table(table_size, empty);
+
+    remap.resize(vertex_count);
+    size_t unique = 0;
+    for (size_t i = 0; i < vertex_count; i++) {
+        const unsigned char* vertex = data + i * stride;
+        size_t slot = hashBytes(vertex, stride) & (table_size - 1);
+        while (table[slot] != empty && std::memcmp(data + table[slot] * stride, vertex, stride) != 0)
+            slot = (slot + 1) & (table_size - 1);
+
+        if (table[slot] == empty) {
+            table[slot] = i;
+            remap[i] = unique++;
+        } else {
+            remap[i] = remap[table[slot]];
+        }
+    }
+    return unique;
+}
+
+void remapVertexBuffer(void* destination, const void* vertices, size_t vertex_count, size_t stride,
+                       const std::vector<uint32_t>& remap)
+{
+    for (size_t i = 0; i < vertex_count; i++)
+        std::memcpy((char*)destination + remap[i] * stride, (const char*)vertices + i * stride, stride);
+}
+
+void optimizeVertexCache(uint32_t* indices, size_t index_count, size_t vertex_count)
+{
+    size_t triangle_count = index_count / 3;
+    if (triangle_count == 0)
+        return;
+
+    // Triângulos de cada vértice; os ainda não emitidos ficam no começo de
+    // adjacency[offsets[v] .. offsets[v] + remaining[v])
+    std::vector<uint32_t> remaining(vertex_count, 0);
+    for (size_t i = 0; i < index_count; i++)
+        remaining[indices[i]]++;
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for (size_t v = 0; v < vertex_count; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<uint32_t> adjacency(index_count);
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < index_count; i++)
+            adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++)
+        vertex_score[v] = vertexScore(-1, remaining[v]);
+
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<uint32_t> output;
+    output.reserve(index_count);
+    std::vector<uint32_t> cache, next_cache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    next_cache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    size_t cursor = 0; // triângulos antes dele já foram emitidos
+    long best = -1;
+
+    for (size_t count = 0; count < triangle_count; count++) {
+        if (best < 0) {
+            // nenhum triângulo pendente usa vértices do cache: recomeça
+            // pelo próximo da ordem original
+            while (emitted[cursor])
+                cursor++;
+            best = cursor;
+        }
+
+        const uint32_t* tri = &indices[3*best];
+        output.insert(output.end(), tri, tri + 3);
+        emitted[best] = true;
+
+        next_cache.clear();
+        for (int k = 0; k < 3; k++) {
+            // um triângulo degenerado aparece mais de uma vez na lista do
+            // vértice repetido; cada canto tira uma
+            uint32_t v = tri[k];
+            uint32_t* list = &adjacency[offsets[v]];
+            for (uint32_t j = 0; j < remaining[v]; j++) {
+                if (list[j] == (uint32_t)best) {
+                    list[j] = list[remaining[v] - 1];
+                    break;
+                }
+            }
+            remaining[v]--;
+            if (std::find(next_cache.begin(), next_cache.end(), v) == next_cache.end())
+                next_cache.push_back(v);
+        }
+        for (size_t i = 0; i < cache.size(); i++)
+            if (cache[i] != tri[0] && cache[i] != tri[1] && cache[i] != tri[2])
+                next_cache.push_back(cache[i]);
+
+        // Atualiza a posição e o escore de quem entrou, ficou ou saiu do
+        // cache e, em seguida, dos triângulos pendentes desses vértices
+        for (size_t i = 0; i < next_cache.size(); i++) {
+            uint32_t v = next_cache[i];
+            cache_position[v] = i < (size_t)FORSYTH_CACHE_SIZE ? (int)i : -1;
+            vertex_score[v] = vertexScore(cache_position[v], remaining[v]);
+        }
+
+        best = -1;
+        float best_score = -1.0f;
+        for (size_t i = 0; i < next_cache.size(); i++) {
+            uint32_t v = next_cache[i];
+            const uint32_t* list = &adjacency[offsets[v]];
+            for (uint32_t j = 0; j < remaining[v]; j++) {
+                uint32_t t = list[j];
+                float score = vertex_score[indices[3*t + 0]] + vertex_score[indices[3*t + 1]] + vertex_score[indices[3*t + 2]];
+                if (cache_position[v] >= 0 && score > best_score) {
+                    best_score = score;
+                    best = t;
+                }
+            }
+        }
+
+        if (next_cache.size() > (size_t)FORSYTH_CACHE_SIZE)
+            next_cache.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(next_cache);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void optimizeOverdraw(uint32_t* indices, size_t index_count, const float* positions, size_t vertex_count,
+                      size_t position_stride, float threshold)
+{
+    size_t triangle_count = index_count / 3;
+    if (triangle_count < 2)
+        return;
+
+    VertexCacheStats original = analyzeVertexCache(indices, index_count, vertex_count);
+
+    // Fronteiras "duras": triângulos em que os três vértices faltam no
+    // cache; mudar a ordem ali não custa nada
+    std::vector<size_t> hard(1, 0);
+    std::vector<unsigned char> misses(triangle_count);
+    {
+        FifoCache cache(vertex_count, VERTEX_CACHE_FIFO_SIZE);
+        for (size_t t = 0; t < triangle_count; t++) {
+            misses[t] = cache.access(indices[3*t + 0]) + cache.access(indices[3*t + 1]) + cache.access(indices[3*t + 2]);
+            if (t > 0 && misses[t] == 3)
+                hard.push_back(t);
+        }
+        hard.push_back(triangle_count);
+    }
+
+    // Fronteiras "suaves": dentro de cada trecho duro, um grupo termina
+    // quando seu ACMR, começando com o cache vazio, já chegou perto do
+    // ACMR do trecho
+    std::vector<size_t> clusters;
+    {
+        FifoCache cache(vertex_count, VERTEX_CACHE_FIFO_SIZE);
+        for (size_t h = 0; h + 1 < hard.size(); h++) {
+            size_t begin = hard[h], end = hard[h + 1];
+            size_t span_misses = 0;
+            for (size_t t = begin; t < end; t++)
+                span_misses += misses[t];
+            float span_acmr = (float)span_misses / (end - begin);
+
+            size_t start = begin;
+            size_t cluster_misses = 0;
+            cache.flush();
+            clusters.push_back(begin);
+            for (size_t t = begin; t + 1 < end; t++) {
+                cluster_misses += cache.access(indices[3*t + 0]) + cache.access(indices[3*t + 1]) + cache.access(indices[3*t + 2]);
+                if ((float)cluster_misses / (t + 1 - start) <= threshold * span_acmr) {
+                    start = t + 1;
+                    cluster_misses = 0;
+                    cache.flush();
+                    clusters.push_back(start);
+                }
+            }
+        }
+        clusters.push_back(triangle_count);
+    }
+    size_t cluster_count = clusters.size() - 1;
+    if (cluster_count < 2)
+        return;
+
+    // Centro e normal de cada grupo, ponderados pela área. Grupos cuja
+    // normal aponta para fora do centro da malha tendem a estar na frente
+    // de qualquer ponto de vista e são desenhados primeiro.
+    std::vector<double> cluster_area(cluster_count, 0.0);
+    std::vector<double> cluster_center(3 * cluster_count, 0.0);
+    std::vector<double> cluster_normal(3 * cluster_count, 0.0);
+    double mesh_center[3] = {0.0, 0.0, 0.0};
+    double mesh_area = 0.0;
+
+    for (size_t c = 0; c < cluster_count; c++) {
+        for (size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+            const float* p0 = positionOf(positions, position_stride, indices[3*t + 0]);
+            const float* p1 = positionOf(positions, position_stride, indices[3*t + 1]);
+            const float* p2 = positionOf(positions, position_stride, indices[3*t + 2]);
+
+            double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            double n[3] = {e1[1]*e2[2] - e1[2]*e2[1], e1[2]*e2[0] - e1[0]*e2[2], e1[0]*e2[1] - e1[1]*e2[0]};
+            double area = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+
+            for (int k = 0; k < 3; k++) {
+                double centroid = (p0[k] + p1[k] + p2[k]) / 3.0;
+                cluster_center[3*c + k] += centroid * area;
+                cluster_normal[3*c + k] += n[k];
+                mesh_center[k] += centroid * area;
+            }
+            cluster_area[c] += area;
+            mesh_area += area;
+        }
+    }
+    if (mesh_area <= 0.0)
+        return;
+    for (int k = 0; k < 3; k++)
+        mesh_center[k] /= mesh_area;
+
+    std::vector<double> sort_key(cluster_count, 0.0);
+    for (size_t c = 0; c < cluster_count; c++) {
+        if (cluster_area[c] <= 0.0)
+            continue;
+        const double* n = &cluster_normal[3*c];
+        double length = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+        if (length <= 0.0)
+            continue;
+        double key = 0.0;
+        for (int k = 0; k < 3; k++)
+            key += (cluster_center[3*c + k] / cluster_area[c] - mesh_center[k]) * n[k] / length;
+        sort_key[c] = key;
+    }
+
+    std::vector<size_t> order(cluster_count);
+    for (size_t c = 0; c < cluster_count; c++)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&sort_key](size_t a, size_t b) { return sort_key[a] > sort_key[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(index_count);
+    for (size_t i = 0; i < cluster_count; i++) {
+        size_t c = order[i];
+        result.insert(result.end(), indices + 3 * clusters[c], indices + 3 * clusters[c + 1]);
+    }
+
+    // Os cortes suaves trocam um pouco de cache por ordem; se a conta
+    // passou do limite, fica a ordem original
+    VertexCacheStats reordered = analyzeVertexCache(result.data(), index_count, vertex_count);
+    if (reordered.acmr <= threshold * original.acmr)
+        std::copy(result.begin(), result.end(), indices);
+}
+
+size_t optimizeVertexFetch(std::vector<uint32_t>& remap, uint32_t* indices, size_t index_count, size_t vertex_count)
+{
+    remap.assign(vertex_count, ~0u);
+    size_t next = 0;
+    for (size_t i = 0; i < index_count; i++) {
+        uint32_t v = indices[i];
+        if (remap[v] == ~0u)
+            remap[v] = next++;
+        indices[i] = remap[v];
+    }
+    return next;
+}
+
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t index_count, size_t vertex_count,
+                                    unsigned int cache_size)
+{
+    VertexCacheStats stats;
+    stats.triangles = index_count / 3;
+
+    FifoCache cache(vertex_count, cache_size);
+    std::vector<bool> used(vertex_count, false);
+    for (size_t i = 0; i < index_count; i++) {
+        uint32_t v = indices[i];
+        if (cache.access(v))
+            stats.transformed++;
+        if (!used[v]) {
+            used[v] = true;
+            stats.vertices++;
+        }
+    }
+
+    if (stats.triangles > 0)
+        stats.acmr = (float)stats.transformed / stats.triangles;
+    if (stats.vertices > 0)
+        stats.atvr = (float)stats.transformed / stats.vertices;
+    return stats;
+}
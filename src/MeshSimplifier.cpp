@@ -0,0 +1,300 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <glm/geometric.hpp>
+
+namespace
+{
+    // Matriz simétrica 4x4 Q; o erro de um ponto p é [p 1] Q [p 1]^T, a
+    // soma das distâncias ao quadrado de p aos planos acumulados
+    struct Quadric
+    {
+        double a2, ab, ac, ad;
+        double b2, bc, bd;
+        double c2, cd;
+        double d2;
+
+        Quadric() : a2(0), ab(0), ac(0), ad(0), b2(0), bc(0), bd(0), c2(0), cd(0), d2(0) {}
+
+        // Plano a*x + b*y + c*z + d = 0, com (a, b, c) unitário, com peso w
+        void addPlane(double a, double b, double c, double d, double w)
+        {
+            a2 += w*a*a; ab += w*a*b; ac += w*a*c; ad += w*a*d;
+            b2 += w*b*b; bc += w*b*c; bd += w*b*d;
+            c2 += w*c*c; cd += w*c*d;
+            d2 += w*d*d;
+        }
+
+        Quadric& operator+=(const Quadric& q)
+        {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+            b2 += q.b2; bc += q.bc; bd += q.bd;
+            c2 += q.c2; cd += q.cd;
+            d2 += q.d2;
+            return *this;
+        }
+
+        double evaluate(const glm::vec3& p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            return a2*x*x + 2*ab*x*y + 2*ac*x*z + 2*ad*x
+                 + b2*y*y + 2*bc*y*z + 2*bd*y
+                 + c2*z*z + 2*cd*z
+                 + d2;
+        }
+    };
+
+    // Colapso candidato from -> to. As versões dos dois vértices no momento
+    // em que foi calculado invalidam a entrada se algum deles mudou depois.
+    struct Collapse
+    {
+        double cost;
+        uint32_t from, to;
+        uint32_t from_version, to_version;
+
+        // std::priority_queue retira o maior; queremos o de menor custo
+        bool operator<(const Collapse& other) const { return cost > other.cost; }
+    };
+
+    class Simplifier
+    {
+        public:
+            Simplifier(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+
+            void run(size_t target_triangles);
+            std::vector<uint32_t> result() const;
+            float maxError() const { return (float)max_error; }
+
+        private:
+            const std::vector<glm::vec3>& positions;
+            std::vector<uint32_t> tris;
+            std::vector<bool> alive;
+            size_t live;
+            std::vector<std::vector<uint32_t> > vertexTris; // triângulos que usam cada vértice (pode ter mortos)
+            std::vector<Quadric> quadrics;
+            std::vector<uint32_t> version;
+            std::vector<bool> removed;
+            std::vector<bool> locked; // na borda: não se move
+            std::priority_queue<Collapse> heap;
+            double max_error;
+
+            void lockBorders();
+            void pushEdge(uint32_t a, uint32_t b);
+            void neighbors(uint32_t v, std::vector<uint32_t>& out) const;
+            bool canCollapse(uint32_t from, uint32_t to) const;
+            void collapse(uint32_t from, uint32_t to);
+    };
+
+    Simplifier::Simplifier(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices)
+        : positions(positions), tris(indices), alive(indices.size() / 3, true), live(indices.size() / 3),
+          vertexTris(positions.size()), quadrics(positions.size()), version(positions.size(), 0),
+          removed(positions.size(), false), locked(positions.size(), false), max_error(0.0)
+    {
+        for (size_t t = 0; t < alive.size(); t++) {
+            const glm::vec3& p0 = positions[tris[3*t + 0]];
+            const glm::vec3& p1 = positions[tris[3*t + 1]];
+            const glm::vec3& p2 = positions[tris[3*t + 2]];
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(n);
+            if (length > 0.0f) {
+                // peso = área: triângulos grandes pesam mais no erro
+                n /= length;
+                Quadric q;
+                q.addPlane(n.x, n.y, n.z, -glm::dot(n, p0), 0.5 * length);
+                for (int k = 0; k < 3; k++)
+                    quadrics[tris[3*t + k]] += q;
+            }
+            for (int k = 0; k < 3; k++)
+                vertexTris[tris[3*t + k]].push_back(t);
+        }
+        lockBorders();
+    }
+
+    // Arestas usadas por um só triângulo (borda) ou por mais de dois (não
+    // manifold) prendem seus vértices
+    void Simplifier::lockBorders()
+    {
+        std::vector<uint64_t> edges;
+        edges.reserve(tris.size());
+        for (size_t t = 0; t < alive.size(); t++) {
+            for (int k = 0; k < 3; k++) {
+                uint64_t a = tris[3*t + k], b = tris[3*t + (k + 1) % 3];
+                edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (size_t i = 0; i < edges.size(); ) {
+            size_t j = i;
+            while (j < edges.size() && edges[j] == edges[i])
+                j++;
+            if (j - i != 2) {
+                locked[edges[i] >> 32] = true;
+                locked[edges[i] & 0xffffffff] = true;
+            }
+            i = j;
+        }
+    }
+
+    void Simplifier::pushEdge(uint32_t a, uint32_t b)
+    {
+        Quadric q = quadrics[a];
+        q += quadrics[b];
+
+        Collapse c;
+        c.cost = std::numeric_limits<double>::max();
+        if (!locked[a]) {
+            c.cost = q.evaluate(positions[b]);
+            c.from = a;
+            c.to = b;
+        }
+        if (!locked[b]) {
+            double cost = q.evaluate(positions[a]);
+            if (cost < c.cost) {
+                c.cost = cost;
+                c.from = b;
+                c.to = a;
+            }
+        }
+        if (c.cost == std::numeric_limits<double>::max())
+            return;
+        c.from_version = version[c.from];
+        c.to_version = version[c.to];
+        heap.push(c);
+    }
+
+    void Simplifier::neighbors(uint32_t v, std::vector<uint32_t>& out) const
+    {
+        out.clear();
+        for (size_t i = 0; i < vertexTris[v].size(); i++) {
+            uint32_t t = vertexTris[v][i];
+            if (!alive[t])
+                continue;
+            for (int k = 0; k < 3; k++)
+                if (tris[3*t + k] != v)
+                    out.push_back(tris[3*t + k]);
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    bool Simplifier::canCollapse(uint32_t from, uint32_t to) const
+    {
+        // Condição de link: os vizinhos comuns de from e to devem ser só os
+        // vértices opostos dos triângulos que somem com a aresta; senão o
+        // colapso cola duas partes da malha
+        std::vector<uint32_t> nf, nt, common;
+        neighbors(from, nf);
+        neighbors(to, nt);
+        std::set_intersection(nf.begin(), nf.end(), nt.begin(), nt.end(), std::back_inserter(common));
+
+        size_t shared = 0;
+        for (size_t i = 0; i < vertexTris[from].size(); i++) {
+            uint32_t t = vertexTris[from][i];
+            if (!alive[t])
+                continue;
+            const uint32_t* tri = &tris[3*t];
+            if (tri[0] == to || tri[1] == to || tri[2] == to) {
+                shared++;
+                continue;
+            }
+
+            // O triângulo continua existindo com "to" no lugar de "from": não
+            // pode virar de lado nem degenerar
+            glm::vec3 p[3], q[3];
+            for (int k = 0; k < 3; k++) {
+                p[k] = positions[tri[k]];
+                q[k] = tri[k] == from ? positions[to] : p[k];
+            }
+            glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+            if (glm::dot(before, after) <= 0.0f)
+                return false;
+        }
+        return common.size() == shared;
+    }
+
+    void Simplifier::collapse(uint32_t from, uint32_t to)
+    {
+        for (size_t i = 0; i < vertexTris[from].size(); i++) {
+            uint32_t t = vertexTris[from][i];
+            if (!alive[t])
+                continue;
+            uint32_t* tri = &tris[3*t];
+            if (tri[0] == to || tri[1] == to || tri[2] == to) {
+                alive[t] = false;
+                live--;
+                continue;
+            }
+            for (int k = 0; k < 3; k++)
+                if (tri[k] == from)
+                    tri[k] = to;
+            vertexTris[to].push_back(t);
+        }
+        vertexTris[from].clear();
+        removed[from] = true;
+        quadrics[to] += quadrics[from];
+        version[from]++;
+        version[to]++;
+
+        // descarta os triângulos mortos e recalcula as arestas em volta de "to"
+        std::vector<uint32_t>& around = vertexTris[to];
+        size_t n = 0;
+        for (size_t i = 0; i < around.size(); i++)
+            if (alive[around[i]])
+                around[n++] = around[i];
+        around.resize(n);
+
+        std::vector<uint32_t> ring;
+        neighbors(to, ring);
+        for (size_t i = 0; i < ring.size(); i++)
+            pushEdge(to, ring[i]);
+    }
+
+    void Simplifier::run(size_t target_triangles)
+    {
+        for (size_t t = 0; t < alive.size(); t++) {
+            for (int k = 0; k < 3; k++) {
+                uint32_t a = tris[3*t + k], b = tris[3*t + (k + 1) % 3];
+                if (a < b) // cada aresta interna aparece nos dois sentidos
+                    pushEdge(a, b);
+            }
+        }
+
+        while (live > target_triangles && !heap.empty()) {
+            Collapse c = heap.top();
+            heap.pop();
+            if (removed[c.from] || removed[c.to] ||
+                version[c.from] != c.from_version || version[c.to] != c.to_version)
+                continue; // entrada velha
+            if (!canCollapse(c.from, c.to))
+                continue;
+            collapse(c.from, c.to);
+            max_error = std::max(max_error, c.cost);
+        }
+    }
+
+    std::vector<uint32_t> Simplifier::result() const
+    {
+        std::vector<uint32_t> out;
+        out.reserve(3 * live);
+        for (size_t t = 0; t < alive.size(); t++)
+            if (alive[t])
+                out.insert(out.end(), tris.begin() + 3*t, tris.begin() + 3*t + 3);
+        return out;
+    }
+}
+
+std::vector<uint32_t> simplifyMesh(const std::vector<glm::vec3>& positions,
+                                   const std::vector<uint32_t>& indices,
+                                   size_t target_triangles,
+                                   float* error)
+{
+    Simplifier simplifier(positions, indices);
+    simplifier.run(target_triangles);
+    if (error != NULL)
+        *error = simplifier.maxError();
+    return simplifier.result();
+}
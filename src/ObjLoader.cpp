@@ -0,0 +1,570 @@
+#include "ObjLoader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+#define NAME_BUFFER_SIZE 4096
+#define NEGATIVE_POWERS  32
+
+namespace
+{
+    // Canto de uma face: índices base 0 de "v", "vt" e "vn" (-1 = ausente)
+    struct Corner
+    {
+        int v, vt, vn;
+    };
+
+    // Linha que não é "v", "vn", "vt", "f" nem comentário, reexecutada em
+    // ordem na junção dos blocos
+    struct Command
+    {
+        const char* line;
+        size_t faces; // faces do bloco antes desta linha
+    };
+
+    struct Chunk
+    {
+        char* begin;
+        char* end;
+        std::vector<float> v, vn, vt;
+        std::vector<Corner> corners;
+        std::vector<unsigned int> faceSizes;
+        std::vector<size_t> relative; // 3*canto + componente dos índices negativos
+        std::vector<Command> commands;
+        size_t vOffset, vnOffset, vtOffset; // floats dos blocos anteriores
+    };
+
+    // Posição na sequência de faces de todos os blocos
+    struct FacePosition
+    {
+        size_t chunk, face, corner;
+    };
+
+    inline bool isSpace(char c) { return c == ' ' || c == '\t'; }
+    inline bool isDigit(char c) { return (unsigned int)(c - '0') < 10u; }
+    inline bool isNewLine(char c) { return c == '\r' || c == '\n' || c == '\0'; }
+    inline bool isTokenEnd(char c) { return c == '\0' || c == '\r' || isSpace(c); }
+
+    inline const char* skipSpaces(const char* s)
+    {
+        while (isSpace(*s))
+            s++;
+        return s;
+    }
+
+    // pow(10, -n), calculado em tempo de execução como tinyobj o calcula (o
+    // "volatile" evita que o compilador troque por uma constante que
+    // poderia diferir no último bit)
+    struct NegativePowersOf10
+    {
+        double value[NEGATIVE_POWERS];
+
+        NegativePowersOf10()
+        {
+            volatile double ten = 10.0;
+            for (int n = 0; n < NEGATIVE_POWERS; n++)
+                value[n] = pow(ten, -n);
+        }
+    };
+    const NegativePowersOf10 negativePowers;
+
+    inline double negativePowerOf10(int n)
+    {
+        return n < NEGATIVE_POWERS ? negativePowers.value[n] : pow(10.0, -n);
+    }
+
+    // O mesmo que tryParseDouble() de tinyobj, operação por operação, mas
+    // com as potências de 10 tabeladas
+    bool parseDouble(const char* s, const char* s_end, double* result)
+    {
+        if (s >= s_end)
+            return false;
+
+        double mantissa = 0.0;
+        int exponent = 0;
+        char sign = '+';
+        const char* curr = s;
+        int read = 0;
+        bool end_not_reached;
+
+        if (*curr == '+' || *curr == '-') {
+            sign = *curr;
+            curr++;
+        } else if (!isDigit(*curr)) {
+            return false;
+        }
+
+        end_not_reached = curr != s_end;
+        while (end_not_reached && isDigit(*curr)) {
+            mantissa *= 10;
+            mantissa += static_cast<int>(*curr - '0');
+            curr++;
+            read++;
+            end_not_reached = curr != s_end;
+        }
+        if (read == 0)
+            return false;
+
+        if (end_not_reached) {
+            if (*curr == '.') {
+                curr++;
+                read = 1;
+                end_not_reached = curr != s_end;
+                while (end_not_reached && isDigit(*curr)) {
+                    mantissa += static_cast<int>(*curr - '0') * negativePowerOf10(read);
+                    read++;
+                    curr++;
+                    end_not_reached = curr != s_end;
+                }
+            } else if (*curr != 'e' && *curr != 'E') {
+                end_not_reached = false; // fim do número
+            }
+        }
+
+        if (end_not_reached && (*curr == 'e' || *curr == 'E')) {
+            char exp_sign = '+';
+            curr++;
+            end_not_reached = curr != s_end;
+            if (end_not_reached && (*curr == '+' || *curr == '-')) {
+                exp_sign = *curr;
+                curr++;
+            } else if (!isDigit(*curr)) {
+                return false;
+            }
+
+            read = 0;
+            end_not_reached = curr != s_end;
+            while (end_not_reached && isDigit(*curr)) {
+                exponent *= 10;
+                exponent += static_cast<int>(*curr - '0');
+                curr++;
+                read++;
+                end_not_reached = curr != s_end;
+            }
+            exponent *= (exp_sign == '+' ? 1 : -1);
+            if (read == 0)
+                return false;
+        }
+
+        // ldexp(m * 5^0, 0) == m
+        if (exponent != 0)
+            mantissa = ldexp(mantissa * pow(5.0, exponent), exponent);
+        *result = (sign == '+' ? 1 : -1) * mantissa;
+        return true;
+    }
+
+    inline float parseFloat(const char** token, double default_value = 0.0)
+    {
+        const char* begin = skipSpaces(*token);
+        const char* end = begin;
+        while (!isTokenEnd(*end))
+            end++;
+        double value = default_value;
+        parseDouble(begin, end, &value);
+        *token = end;
+        return static_cast<float>(value);
+    }
+
+    // atoi() sem locale
+    inline int parseInt(const char* s)
+    {
+        while (*s == ' ' || (unsigned int)(*s - '\t') <= '\r' - '\t')
+            s++;
+        bool negative = false;
+        if (*s == '+' || *s == '-')
+            negative = *s++ == '-';
+        unsigned int value = 0;
+        while (isDigit(*s))
+            value = value * 10 + (*s++ - '0');
+        return negative ? -(int)value : (int)value;
+    }
+
+    inline const char* skipIndex(const char* s)
+    {
+        while (*s != '/' && !isTokenEnd(*s))
+            s++;
+        return s;
+    }
+
+    // Índice base 0 como o fixIndex() de tinyobj. Os relativos são contados
+    // a partir do início do bloco e anotados para a correção na junção.
+    inline int fixIndex(int index, size_t count, Chunk& chunk, size_t component)
+    {
+        if (index > 0)
+            return index - 1;
+        if (index == 0)
+            return 0;
+        chunk.relative.push_back(3 * chunk.corners.size() + component);
+        return (int)count + index;
+    }
+
+    // i, i/j/k, i//k, i/j (o parseTriple() de tinyobj)
+    Corner parseCorner(const char** token, Chunk& chunk)
+    {
+        Corner corner = { -1, -1, -1 };
+        const char* s = *token;
+
+        corner.v = fixIndex(parseInt(s), chunk.v.size() / 3, chunk, 0);
+        s = skipIndex(s);
+        if (*s == '/') {
+            s++;
+            if (*s == '/') {
+                s++;
+                corner.vn = fixIndex(parseInt(s), chunk.vn.size() / 3, chunk, 2);
+                s = skipIndex(s);
+            } else {
+                corner.vt = fixIndex(parseInt(s), chunk.vt.size() / 2, chunk, 1);
+                s = skipIndex(s);
+                if (*s == '/') {
+                    s++;
+                    corner.vn = fixIndex(parseInt(s), chunk.vn.size() / 3, chunk, 2);
+                    s = skipIndex(s);
+                }
+            }
+        }
+
+        *token = s;
+        return corner;
+    }
+
+    void parseLine(const char* token, Chunk& chunk)
+    {
+        token = skipSpaces(token);
+        if (token[0] == '\0' || token[0] == '#')
+            return;
+
+        if (token[0] == 'v' && isSpace(token[1])) {
+            token += 2;
+            for (int i = 0; i < 3; i++)
+                chunk.v.push_back(parseFloat(&token));
+        } else if (token[0] == 'v' && token[1] == 'n' && isSpace(token[2])) {
+            token += 3;
+            for (int i = 0; i < 3; i++)
+                chunk.vn.push_back(parseFloat(&token));
+        } else if (token[0] == 'v' && token[1] == 't' && isSpace(token[2])) {
+            token += 3;
+            for (int i = 0; i < 2; i++)
+                chunk.vt.push_back(parseFloat(&token));
+        } else if (token[0] == 'f' && isSpace(token[1])) {
+            token = skipSpaces(token + 2);
+            size_t first = chunk.corners.size();
+            while (!isNewLine(token[0])) {
+                Corner corner = parseCorner(&token, chunk);
+                chunk.corners.push_back(corner);
+                token += strspn(token, " \t\r");
+            }
+            chunk.faceSizes.push_back(chunk.corners.size() - first);
+        } else {
+            Command command;
+            command.line = token;
+            command.faces = chunk.faceSizes.size();
+            chunk.commands.push_back(command);
+        }
+    }
+
+    void parseChunk(Chunk& chunk)
+    {
+        char* line = chunk.begin;
+        while (line < chunk.end) {
+            // Só o último bloco pode terminar sem '\n'; aí "end" é o '\0'
+            // depois do arquivo
+            char* line_end = (char*)memchr(line, '\n', chunk.end - line);
+            if (line_end == NULL)
+                line_end = chunk.end;
+            *line_end = '\0';
+            if (line_end > line && line_end[-1] == '\r')
+                line_end[-1] = '\0';
+
+            parseLine(line, chunk);
+            line = line_end + 1;
+        }
+    }
+
+    // Reexecuta as linhas anotadas em ordem, com o estado e as regras de
+    // tinyobj::LoadObj(): as faces lidas desde a última exportação formam o
+    // "face group", que vai para "shape" a cada "usemtl" que troca o
+    // material, e "shape" vai para "shapes" a cada "g" ou "o".
+    class ShapeAssembler
+    {
+        public:
+            ShapeAssembler(const std::vector<Chunk>& chunks, bool triangulate)
+                : chunks(chunks), triangulate(triangulate), material(-1), pending(0)
+            {
+                group.chunk = group.face = group.corner = 0;
+            }
+
+            bool run(std::vector<tinyobj::shape_t>* shapes, std::vector<tinyobj::material_t>* materials,
+                     std::string* err, const char* mtl_basepath)
+            {
+                tinyobj::MaterialFileReader readMaterials(mtl_basepath != NULL ? mtl_basepath : "");
+
+                for (size_t c = 0; c < chunks.size(); c++) {
+                    const Chunk& chunk = chunks[c];
+                    size_t faces = 0;
+                    for (size_t i = 0; i < chunk.commands.size(); i++) {
+                        const Command& command = chunk.commands[i];
+                        pending += command.faces - faces;
+                        faces = command.faces;
+                        if (!runCommand(command.line, shapes, materials, err, readMaterials))
+                            return false;
+                    }
+                    pending += chunk.faceSizes.size() - faces;
+                }
+
+                if (exportGroup())
+                    shapes->push_back(shape);
+                return true;
+            }
+
+        protected:
+
+        private:
+            const std::vector<Chunk>& chunks;
+            bool triangulate;
+
+            std::vector<tinyobj::tag_t> tags;
+            std::string name;
+            std::map<std::string, int> materialMap;
+            int material;
+            tinyobj::shape_t shape;
+
+            FacePosition group; // primeira face do face group
+            size_t pending;     // faces no face group
+
+            static void readName(const char* token, char* name)
+            {
+                name[0] = '\0';
+                sscanf(token, "%4095s", name);
+            }
+
+            static tinyobj::index_t toIndex(const Corner& corner)
+            {
+                tinyobj::index_t index;
+                index.vertex_index = corner.v;
+                index.normal_index = corner.vn;
+                index.texcoord_index = corner.vt;
+                return index;
+            }
+
+            // exportFaceGroupToShape() seguido de faceGroup.clear()
+            bool exportGroup()
+            {
+                if (pending == 0)
+                    return false;
+
+                while (pending > 0) {
+                    const Chunk& chunk = chunks[group.chunk];
+                    if (group.face == chunk.faceSizes.size()) {
+                        group.chunk++;
+                        group.face = group.corner = 0;
+                        continue;
+                    }
+
+                    const Corner* face = chunk.corners.data() + group.corner;
+                    unsigned int size = chunk.faceSizes[group.face];
+                    if (triangulate) {
+                        // polígono -> leque de triângulos
+                        for (unsigned int k = 2; k < size; k++) {
+                            shape.mesh.indices.push_back(toIndex(face[0]));
+                            shape.mesh.indices.push_back(toIndex(face[k - 1]));
+                            shape.mesh.indices.push_back(toIndex(face[k]));
+                            shape.mesh.num_face_vertices.push_back(3);
+                            shape.mesh.material_ids.push_back(material);
+                        }
+                    } else {
+                        for (unsigned int k = 0; k < size; k++)
+                            shape.mesh.indices.push_back(toIndex(face[k]));
+                        shape.mesh.num_face_vertices.push_back(static_cast<unsigned char>(size));
+                        shape.mesh.material_ids.push_back(material);
+                    }
+
+                    group.face++;
+                    group.corner += size;
+                    pending--;
+                }
+
+                shape.name = name;
+                shape.mesh.tags = tags;
+                return true;
+            }
+
+            bool runCommand(const char* token, std::vector<tinyobj::shape_t>* shapes,
+                            std::vector<tinyobj::material_t>* materials, std::string* err,
+                            tinyobj::MaterialReader& readMaterials)
+            {
+                char namebuf[NAME_BUFFER_SIZE];
+
+                if (strncmp(token, "usemtl", 6) == 0 && isSpace(token[6])) {
+                    readName(token + 7, namebuf);
+                    std::map<std::string, int>::const_iterator it = materialMap.find(namebuf);
+                    int newMaterialId = it != materialMap.end() ? it->second : -1;
+                    if (newMaterialId != material) {
+                        exportGroup();
+                        material = newMaterialId;
+                    }
+                } else if (strncmp(token, "mtllib", 6) == 0 && isSpace(token[6])) {
+                    readName(token + 7, namebuf);
+                    std::string err_mtl;
+                    bool ok = readMaterials(namebuf, materials, &materialMap, &err_mtl);
+                    if (err)
+                        (*err) += err_mtl;
+                    if (!ok)
+                        return false;
+                } else if (token[0] == 'g' && isSpace(token[1])) {
+                    if (exportGroup())
+                        shapes->push_back(shape);
+                    shape = tinyobj::shape_t();
+
+                    // o primeiro nome é o próprio "g"
+                    std::vector<std::string> names;
+                    while (!isNewLine(token[0])) {
+                        token = skipSpaces(token);
+                        size_t length = strcspn(token, " \t\r");
+                        names.push_back(std::string(token, length));
+                        token += length;
+                        token += strspn(token, " \t\r");
+                    }
+                    name = names.size() > 1 ? names[1] : "";
+                } else if (token[0] == 'o' && isSpace(token[1])) {
+                    if (exportGroup())
+                        shapes->push_back(shape);
+                    shape = tinyobj::shape_t();
+
+                    readName(token + 2, namebuf);
+                    name = namebuf;
+                } else if (token[0] == 't' && isSpace(token[1])) {
+                    parseTag(token + 2);
+                }
+                // Outros comandos são ignorados, como em tinyobj
+                return true;
+            }
+
+            // "t nome inteiros/floats/strings valores...", como em tinyobj
+            void parseTag(const char* token)
+            {
+                tinyobj::tag_t tag;
+                char namebuf[NAME_BUFFER_SIZE];
+                readName(token, namebuf);
+                tag.name = namebuf;
+                token += tag.name.size() + 1;
+
+                int sizes[3] = { 0, 0, 0 };
+                for (int i = 0; i < 3; i++) {
+                    sizes[i] = atoi(token);
+                    token += strcspn(token, "/ \t\r");
+                    if (i == 2)
+                        token++;
+                    else if (token[0] != '/')
+                        break;
+                    else
+                        token++;
+                }
+
+                tag.intValues.resize(sizes[0]);
+                for (int i = 0; i < sizes[0]; i++) {
+                    tag.intValues[i] = atoi(token);
+                    token += strcspn(token, "/ \t\r") + 1;
+                }
+                tag.floatValues.resize(sizes[1]);
+                for (int i = 0; i < sizes[1]; i++) {
+                    tag.floatValues[i] = parseFloat(&token);
+                    token += strcspn(token, "/ \t\r") + 1;
+                }
+                tag.stringValues.resize(sizes[2]);
+                for (int i = 0; i < sizes[2]; i++) {
+                    char value[NAME_BUFFER_SIZE];
+                    readName(token, value);
+                    tag.stringValues[i] = value;
+                    token += tag.stringValues[i].size() + 1;
+                }
+
+                tags.push_back(tag);
+            }
+    };
+}
+
+bool loadObjParallel(tinyobj::attrib_t* attrib, std::vector<tinyobj::shape_t>* shapes,
+                     std::vector<tinyobj::material_t>* materials, std::string* err,
+                     const char* filename, const char* mtl_basepath, bool triangulate,
+                     JobSystem& jobs)
+{
+    attrib->vertices.clear();
+    attrib->normals.clear();
+    attrib->texcoords.clear();
+    shapes->clear();
+
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) {
+        if (err)
+            *err = std::string("Cannot open file [") + filename + "]\n";
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    size_t size = file_size > 0 ? (size_t)file_size : 0;
+
+    // +1: o '\0' que termina a última linha
+    std::vector<char> buffer(size + 1);
+    size = fread(buffer.data(), 1, size, file);
+    fclose(file);
+    buffer[size] = '\0';
+
+    // Blocos terminados logo depois de um '\n' (ou no fim do arquivo)
+    std::vector<Chunk> chunks;
+    char* data = buffer.data();
+    size_t begin = 0;
+    while (begin < size) {
+        size_t end = std::min(begin + (size_t)OBJ_LOADER_CHUNK_SIZE, size);
+        const char* newline = (const char*)memchr(data + end - 1, '\n', size - (end - 1));
+        end = newline != NULL ? newline - data + 1 : size;
+
+        chunks.push_back(Chunk());
+        chunks.back().begin = data + begin;
+        chunks.back().end = data + end;
+        begin = end;
+    }
+
+    jobs.parallelFor(0, chunks.size(), 1, [&chunks](size_t first, size_t last) {
+        for (size_t c = first; c < last; c++)
+            parseChunk(chunks[c]);
+    });
+
+    size_t num_v = 0, num_vn = 0, num_vt = 0;
+    for (size_t c = 0; c < chunks.size(); c++) {
+        chunks[c].vOffset = num_v;
+        chunks[c].vnOffset = num_vn;
+        chunks[c].vtOffset = num_vt;
+        num_v += chunks[c].v.size();
+        num_vn += chunks[c].vn.size();
+        num_vt += chunks[c].vt.size();
+    }
+    attrib->vertices.resize(num_v);
+    attrib->normals.resize(num_vn);
+    attrib->texcoords.resize(num_vt);
+
+    jobs.parallelFor(0, chunks.size(), 1, [&chunks, attrib](size_t first, size_t last) {
+        for (size_t c = first; c < last; c++) {
+            Chunk& chunk = chunks[c];
+            std::copy(chunk.v.begin(), chunk.v.end(), attrib->vertices.begin() + chunk.vOffset);
+            std::copy(chunk.vn.begin(), chunk.vn.end(), attrib->normals.begin() + chunk.vnOffset);
+            std::copy(chunk.vt.begin(), chunk.vt.end(), attrib->texcoords.begin() + chunk.vtOffset);
+
+            for (size_t i = 0; i < chunk.relative.size(); i++) {
+                Corner& corner = chunk.corners[chunk.relative[i] / 3];
+                switch (chunk.relative[i] % 3) {
+                    case 0: corner.v  += chunk.vOffset / 3; break;
+                    case 1: corner.vt += chunk.vtOffset / 2; break;
+                    case 2: corner.vn += chunk.vnOffset / 3; break;
+                }
+            }
+        }
+    });
+
+    ShapeAssembler assembler(chunks, triangulate);
+    return assembler.run(shapes, materials, err, mtl_basepath);
+}
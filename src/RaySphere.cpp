@@ -0,0 +1,202 @@
+#include "RaySphere.h"
+
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RAYSPHERE_X86
+#include <immintrin.h>
+#endif
+
+void SpherePack::clear()
+{
+    x.clear(); y.clear(); z.clear();
+    radius2.clear();
+    id.clear();
+}
+
+void SpherePack::add(uint32_t id, glm::vec3 center, float radius)
+{
+    x.push_back(center.x);
+    y.push_back(center.y);
+    z.push_back(center.z);
+    radius2.push_back(radius * radius);
+    this->id.push_back(id);
+}
+
+void RayPack::clear()
+{
+    ox.clear(); oy.clear(); oz.clear();
+    dx.clear(); dy.clear(); dz.clear();
+    a.clear();
+    tmax.clear();
+    id.clear();
+}
+
+void RayPack::add(uint32_t id, glm::vec3 origin, glm::vec3 direction, float tmax)
+{
+    ox.push_back(origin.x);
+    oy.push_back(origin.y);
+    oz.push_back(origin.z);
+    dx.push_back(direction.x);
+    dy.push_back(direction.y);
+    dz.push_back(direction.z);
+    a.push_back(direction.x*direction.x + direction.y*direction.y + direction.z*direction.z);
+    this->tmax.push_back(tmax);
+    this->id.push_back(id);
+}
+
+// Com m = origem - centro, a equação |m + d*t|^2 = r^2 fica
+//
+//     a*t^2 + 2*b*t + c = 0,   a = d.d,  b = d.m,  c = m.m - r^2
+//
+// com raízes (-b -+ sqrt(b^2 - a*c)) / a. O segmento acerta a esfera se
+// houver raiz real e o intervalo entre as raízes tocar [0, tmax], que é o
+// mesmo critério do antigo GameWorld::testInterseption(asteroide, tiro).
+namespace
+{
+    struct Ray
+    {
+        float ox, oy, oz;
+        float dx, dy, dz;
+        float a, tmax;
+        uint32_t id;
+    };
+
+    // Testa as esferas [begin, end) contra o raio
+    void intersectScalar(const Ray& r, const SpherePack& s, size_t begin, size_t end, std::vector<RayHit>& hits)
+    {
+        for (size_t i = begin; i < end; i++) {
+            float mx = r.ox - s.x[i];
+            float my = r.oy - s.y[i];
+            float mz = r.oz - s.z[i];
+            float b = r.dx*mx + r.dy*my + r.dz*mz;
+            float c = mx*mx + my*my + mz*mz - s.radius2[i];
+            float disc = b*b - r.a*c;
+            if (disc < 0.0f)
+                continue;
+            float sq = sqrtf(disc);
+            if (sq - b < 0.0f || -b - sq > r.tmax * r.a)
+                continue;
+            RayHit hit;
+            hit.ray = r.id;
+            hit.sphere = s.id[i];
+            hit.t = (-b - sq) > 0.0f ? (-b - sq) / r.a : 0.0f;
+            hits.push_back(hit);
+        }
+    }
+
+#ifdef RAYSPHERE_X86
+
+    // Acrescenta os acertos marcados em "mask" a partir da esfera "base";
+    // "entry" tem -b - sqrt(disc) de cada pista
+    void emitHits(const Ray& r, const SpherePack& s, size_t base, int mask, const float* entry, std::vector<RayHit>& hits)
+    {
+        for (int lane = 0; mask != 0; lane++, mask >>= 1) {
+            if (!(mask & 1))
+                continue;
+            RayHit hit;
+            hit.ray = r.id;
+            hit.sphere = s.id[base + lane];
+            hit.t = entry[lane] > 0.0f ? entry[lane] / r.a : 0.0f;
+            hits.push_back(hit);
+        }
+    }
+
+    // 4 esferas por vez. Retorna quantas foram processadas; o restante fica
+    // para o laço escalar.
+    __attribute__((target("sse")))
+    size_t intersectSSE(const Ray& r, const SpherePack& s, std::vector<RayHit>& hits)
+    {
+        const size_t n = s.size() & ~size_t(3);
+        const __m128 ox = _mm_set1_ps(r.ox), oy = _mm_set1_ps(r.oy), oz = _mm_set1_ps(r.oz);
+        const __m128 dx = _mm_set1_ps(r.dx), dy = _mm_set1_ps(r.dy), dz = _mm_set1_ps(r.dz);
+        const __m128 a = _mm_set1_ps(r.a);
+        const __m128 limit = _mm_set1_ps(r.tmax * r.a);
+        const __m128 zero = _mm_setzero_ps();
+        float entry[4];
+
+        for (size_t i = 0; i < n; i += 4) {
+            __m128 mx = _mm_sub_ps(ox, _mm_loadu_ps(&s.x[i]));
+            __m128 my = _mm_sub_ps(oy, _mm_loadu_ps(&s.y[i]));
+            __m128 mz = _mm_sub_ps(oz, _mm_loadu_ps(&s.z[i]));
+            __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, mx), _mm_mul_ps(dy, my)), _mm_mul_ps(dz, mz));
+            __m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(mx, mx), _mm_mul_ps(my, my)), _mm_mul_ps(mz, mz)),
+                                  _mm_loadu_ps(&s.radius2[i]));
+            __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+            __m128 real = _mm_cmpge_ps(disc, zero);
+            if (_mm_movemask_ps(real) == 0)
+                continue;
+
+            __m128 sq = _mm_sqrt_ps(_mm_max_ps(disc, zero));
+            __m128 leave = _mm_sub_ps(sq, b);
+            __m128 enter = _mm_sub_ps(_mm_sub_ps(zero, b), sq);
+            __m128 hit = _mm_and_ps(real, _mm_and_ps(_mm_cmpge_ps(leave, zero), _mm_cmple_ps(enter, limit)));
+            int mask = _mm_movemask_ps(hit);
+            if (mask == 0)
+                continue;
+            _mm_storeu_ps(entry, enter);
+            emitHits(r, s, i, mask, entry, hits);
+        }
+        return n;
+    }
+
+    // 8 esferas por vez. Compilada com suporte a AVX mesmo sem -mavx; só é
+    // chamada se a CPU suportar (veja intersectRay()).
+    __attribute__((target("avx")))
+    size_t intersectAVX(const Ray& r, const SpherePack& s, std::vector<RayHit>& hits)
+    {
+        const size_t n = s.size() & ~size_t(7);
+        const __m256 ox = _mm256_set1_ps(r.ox), oy = _mm256_set1_ps(r.oy), oz = _mm256_set1_ps(r.oz);
+        const __m256 dx = _mm256_set1_ps(r.dx), dy = _mm256_set1_ps(r.dy), dz = _mm256_set1_ps(r.dz);
+        const __m256 a = _mm256_set1_ps(r.a);
+        const __m256 limit = _mm256_set1_ps(r.tmax * r.a);
+        const __m256 zero = _mm256_setzero_ps();
+        float entry[8];
+
+        for (size_t i = 0; i < n; i += 8) {
+            __m256 mx = _mm256_sub_ps(ox, _mm256_loadu_ps(&s.x[i]));
+            __m256 my = _mm256_sub_ps(oy, _mm256_loadu_ps(&s.y[i]));
+            __m256 mz = _mm256_sub_ps(oz, _mm256_loadu_ps(&s.z[i]));
+            __m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, mx), _mm256_mul_ps(dy, my)), _mm256_mul_ps(dz, mz));
+            __m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(mx, mx), _mm256_mul_ps(my, my)), _mm256_mul_ps(mz, mz)),
+                                     _mm256_loadu_ps(&s.radius2[i]));
+            __m256 disc = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+            __m256 real = _mm256_cmp_ps(disc, zero, _CMP_GE_OQ);
+            if (_mm256_movemask_ps(real) == 0)
+                continue;
+
+            __m256 sq = _mm256_sqrt_ps(_mm256_max_ps(disc, zero));
+            __m256 leave = _mm256_sub_ps(sq, b);
+            __m256 enter = _mm256_sub_ps(_mm256_sub_ps(zero, b), sq);
+            __m256 hit = _mm256_and_ps(real, _mm256_and_ps(_mm256_cmp_ps(leave, zero, _CMP_GE_OQ),
+                                                           _mm256_cmp_ps(enter, limit, _CMP_LE_OQ)));
+            int mask = _mm256_movemask_ps(hit);
+            if (mask == 0)
+                continue;
+            _mm256_storeu_ps(entry, enter);
+            emitHits(r, s, i, mask, entry, hits);
+        }
+        return n;
+    }
+
+#endif // RAYSPHERE_X86
+}
+
+void intersectRay(const RayPack& rays, size_t ray, const SpherePack& spheres, std::vector<RayHit>& hits)
+{
+    Ray r;
+    r.ox = rays.ox[ray]; r.oy = rays.oy[ray]; r.oz = rays.oz[ray];
+    r.dx = rays.dx[ray]; r.dy = rays.dy[ray]; r.dz = rays.dz[ray];
+    r.a = rays.a[ray];
+    r.tmax = rays.tmax[ray];
+    r.id = rays.id[ray];
+    if (r.a <= 0.0f) // tiro parado não tem rastro
+        return;
+
+    size_t done = 0;
+#ifdef RAYSPHERE_X86
+    static const bool has_avx = __builtin_cpu_supports("avx");
+    done = has_avx ? intersectAVX(r, spheres, hits) : intersectSSE(r, spheres, hits);
+#endif
+    intersectScalar(r, spheres, done, spheres.size(), hits);
+}
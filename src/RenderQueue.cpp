@@ -0,0 +1,145 @@
+#include "RenderQueue.h"
+
+// Bits de cada campo da chave, do mais para o menos significativo
+#define KEY_PROGRAM_BITS  8
+#define KEY_VAO_BITS      16
+#define KEY_MATERIAL_BITS 16
+#define KEY_DEPTH_BITS    24
+
+RenderQueue::RenderQueue(float max_depth)
+    : maxDepth(max_depth)
+{
+    //ctor
+}
+
+RenderQueue::~RenderQueue()
+{
+    //dtor
+}
+
+void RenderQueue::submit(const DrawItem& item)
+{
+    items.push_back(item);
+    keys.push_back(sortKey(item));
+}
+
+uint64_t RenderQueue::sortKey(const DrawItem& item) const
+{
+    const uint64_t depth_max = (uint64_t(1) << KEY_DEPTH_BITS) - 1;
+    float d = item.depth / maxDepth;
+    d = d < 0.0f ? 0.0f : (d > 1.0f ? 1.0f : d);
+
+    uint64_t program  = item.program & ((1 << KEY_PROGRAM_BITS) - 1);
+    uint64_t vao      = item.vertex_array_object_id & ((1 << KEY_VAO_BITS) - 1);
+    uint64_t material = ((item.object_id & 0xff) << 2) | ((item.need_texture & 1) << 1) | (item.instances > 0 ? 1 : 0);
+    uint64_t depth    = (uint64_t)(d * depth_max);
+
+    return (program << (KEY_VAO_BITS + KEY_MATERIAL_BITS + KEY_DEPTH_BITS))
+         | (vao << (KEY_MATERIAL_BITS + KEY_DEPTH_BITS))
+         | (material << KEY_DEPTH_BITS)
+         | depth;
+}
+
+// Radix sort LSD de 8 bits por passada sobre (chave, índice). Passadas em que
+// todos os itens têm o mesmo dígito (p.ex. um único programa) são puladas.
+void RenderQueue::sort()
+{
+    size_t n = items.size();
+    order.resize(n);
+    for (size_t i = 0; i < n; i++)
+        order[i] = i;
+    keysScratch.resize(n);
+    orderScratch.resize(n);
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t count[256] = {0};
+        for (size_t i = 0; i < n; i++)
+            count[(keys[i] >> shift) & 0xff]++;
+        if (count[(keys[0] >> shift) & 0xff] == n)
+            continue;
+
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            size_t dst = count[(keys[i] >> shift) & 0xff]++;
+            keysScratch[dst] = keys[i];
+            orderScratch[dst] = order[i];
+        }
+        keys.swap(keysScratch);
+        order.swap(orderScratch);
+    }
+}
+
+void RenderQueue::count(bool uploaded)
+{
+    if (uploaded)
+        stats.binds++;
+    else
+        stats.bindsAvoided++;
+}
+
+void RenderQueue::flush()
+{
+    stats = RenderStats();
+    if (items.empty())
+        return;
+
+    sort();
+
+    // programa e VAO atuais; inválidos no início de cada quadro, já que
+    // outros códigos (texto, skybox) mexem neles entre um flush e outro. Os
+    // valores dos uniforms ficam nos handles de cada programa.
+    GLuint program = 0;
+    GLuint vao = 0;
+    bool first = true;
+
+    for (size_t k = 0; k < order.size(); k++) {
+        const DrawItem& item = items[order[k]];
+        RenderUniforms& u = *item.uniforms;
+
+        if (first || item.program != program) {
+            glUseProgram(item.program);
+            program = item.program;
+            stats.binds++;
+        } else {
+            stats.bindsAvoided++;
+        }
+
+        if (first || item.vertex_array_object_id != vao) {
+            glBindVertexArray(item.vertex_array_object_id);
+            vao = item.vertex_array_object_id;
+            stats.binds++;
+        } else {
+            stats.bindsAvoided++;
+        }
+        first = false;
+
+        set(u.object_id, item.object_id);
+        set(u.need_texture, item.need_texture);
+        set(u.instanced, item.instances > 0 ? 1 : 0);
+        if (u.bbox_min.location >= 0 || u.bbox_max.location >= 0) {
+            bool bbox_min = u.bbox_min.set(glm::vec4(item.bbox_min, 1.0f));
+            bool bbox_max = u.bbox_max.set(glm::vec4(item.bbox_max, 1.0f));
+            count(bbox_min || bbox_max);
+        }
+        set(u.material_base, item.material_base);
+
+        if (item.instances > 0) {
+            glDrawElementsInstanced(item.rendering_mode, item.num_indices, GL_UNSIGNED_INT,
+                                    (void*)(item.first_index * sizeof(GLuint)), item.instances);
+        } else {
+            u.model.set(item.model);
+            glDrawElements(item.rendering_mode, item.num_indices, GL_UNSIGNED_INT,
+                           (void*)(item.first_index * sizeof(GLuint)));
+        }
+        stats.draws++;
+    }
+
+    glBindVertexArray(0);
+    items.clear();
+    keys.clear();
+}
@@ -0,0 +1,181 @@
+#include "SpatialHash.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <glm/common.hpp>
+
+SpatialHash::SpatialHash(float cellSize)
+    : cellSize(cellSize)
+{
+    //ctor
+}
+
+SpatialHash::~SpatialHash()
+{
+    //dtor
+}
+
+void SpatialHash::clear()
+{
+    entries.clear();
+}
+
+glm::ivec3 SpatialHash::cellCoords(glm::vec3 p) const
+{
+    return glm::ivec3((int)floorf(p.x / cellSize),
+                      (int)floorf(p.y / cellSize),
+                      (int)floorf(p.z / cellSize));
+}
+
+// 21 bits por eixo. Coordenadas muito distantes podem cair na mesma chave,
+// o que só gera candidatos a mais (descartados pelo teste de AABB).
+uint64_t SpatialHash::cellKey(glm::ivec3 c)
+{
+    const uint64_t mask = (1 << 21) - 1;
+    return ((uint64_t)(c.x & mask) << 42) | ((uint64_t)(c.y & mask) << 21) | (uint64_t)(c.z & mask);
+}
+
+void SpatialHash::insert(uint32_t id, glm::vec3 bbox_min, glm::vec3 bbox_max)
+{
+    if (id >= itemMin.size()) {
+        itemMin.resize(id + 1);
+        itemMax.resize(id + 1);
+    }
+    itemMin[id] = bbox_min;
+    itemMax[id] = bbox_max;
+
+    glm::ivec3 lo = cellCoords(bbox_min);
+    glm::ivec3 hi = cellCoords(bbox_max);
+    for (int x = lo.x; x <= hi.x; x++)
+        for (int y = lo.y; y <= hi.y; y++)
+            for (int z = lo.z; z <= hi.z; z++) {
+                Entry entry;
+                entry.cell = cellKey(glm::ivec3(x, y, z));
+                entry.id = id;
+                entries.push_back(entry);
+            }
+}
+
+void SpatialHash::build()
+{
+    std::sort(entries.begin(), entries.end());
+}
+
+bool SpatialHash::overlaps(uint32_t id, glm::vec3 bbox_min, glm::vec3 bbox_max) const
+{
+    return itemMin[id].x <= bbox_max.x && itemMax[id].x >= bbox_min.x
+        && itemMin[id].y <= bbox_max.y && itemMax[id].y >= bbox_min.y
+        && itemMin[id].z <= bbox_max.z && itemMax[id].z >= bbox_min.z;
+}
+
+void SpatialHash::findPairs(std::vector<std::pair<uint32_t, uint32_t> >& pairs) const
+{
+    pairs.clear();
+
+    size_t begin = 0;
+    while (begin < entries.size()) {
+        size_t end = begin + 1;
+        while (end < entries.size() && entries[end].cell == entries[begin].cell)
+            end++;
+
+        for (size_t i = begin; i < end; i++) {
+            uint32_t a = entries[i].id;
+            for (size_t j = i + 1; j < end; j++) {
+                uint32_t b = entries[j].id;
+                if (!overlaps(a, itemMin[b], itemMax[b]))
+                    continue;
+                // Um par que compartilha várias células só é reportado pela
+                // célula que contém o canto mínimo da interseção das AABBs.
+                glm::vec3 corner = glm::max(itemMin[a], itemMin[b]);
+                if (cellKey(cellCoords(corner)) != entries[begin].cell)
+                    continue;
+                pairs.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+            }
+        }
+        begin = end;
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+}
+
+// Um item que ocupa várias células aparece uma vez por célula visitada;
+// ordenar e remover repetidos no fim mantém as consultas sem estado, de
+// forma que várias threads podem consultar a mesma grade ao mesmo tempo
+void SpatialHash::endQuery(std::vector<uint32_t>& ids) const
+{
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+// Adiciona a ids os itens da célula cuja AABB sobrepõe bbox_min..bbox_max
+void SpatialHash::collectCell(glm::ivec3 cell, glm::vec3 bbox_min, glm::vec3 bbox_max, std::vector<uint32_t>& ids) const
+{
+    Entry key;
+    key.cell = cellKey(cell);
+    key.id = 0;
+    std::vector<Entry>::const_iterator it = std::lower_bound(entries.begin(), entries.end(), key);
+    for (; it != entries.end() && it->cell == key.cell; ++it) {
+        uint32_t id = it->id;
+        if (overlaps(id, bbox_min, bbox_max))
+            ids.push_back(id);
+    }
+}
+
+void SpatialHash::query(glm::vec3 bbox_min, glm::vec3 bbox_max, std::vector<uint32_t>& ids) const
+{
+    ids.clear();
+
+    glm::ivec3 lo = cellCoords(bbox_min);
+    glm::ivec3 hi = cellCoords(bbox_max);
+    for (int x = lo.x; x <= hi.x; x++)
+        for (int y = lo.y; y <= hi.y; y++)
+            for (int z = lo.z; z <= hi.z; z++)
+                collectCell(glm::ivec3(x, y, z), bbox_min, bbox_max, ids);
+
+    endQuery(ids);
+}
+
+void SpatialHash::querySegment(glm::vec3 p0, glm::vec3 p1, std::vector<uint32_t>& ids) const
+{
+    ids.clear();
+
+    glm::vec3 bbox_min = glm::min(p0, p1);
+    glm::vec3 bbox_max = glm::max(p0, p1);
+    glm::ivec3 cell = cellCoords(p0);
+    glm::ivec3 last = cellCoords(p1);
+    glm::vec3 d = p1 - p0;
+
+    // para cada eixo: direção do passo, parâmetro (0..1) da próxima
+    // fronteira de célula e quanto o parâmetro avança por célula
+    glm::ivec3 step;
+    glm::vec3 next, delta;
+    for (int k = 0; k < 3; k++) {
+        if (d[k] > 0.0f) {
+            step[k] = 1;
+            next[k] = ((cell[k] + 1) * cellSize - p0[k]) / d[k];
+            delta[k] = cellSize / d[k];
+        } else if (d[k] < 0.0f) {
+            step[k] = -1;
+            next[k] = (cell[k] * cellSize - p0[k]) / d[k];
+            delta[k] = -cellSize / d[k];
+        } else {
+            step[k] = 0;
+            next[k] = INFINITY;
+            delta[k] = INFINITY;
+        }
+    }
+
+    // o número de células visitadas é limitado pela distância em células,
+    // o que protege contra erros de arredondamento na última fronteira
+    int remaining = abs(last.x - cell.x) + abs(last.y - cell.y) + abs(last.z - cell.z);
+    collectCell(cell, bbox_min, bbox_max, ids);
+    while (remaining-- > 0) {
+        int k = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+        cell[k] += step[k];
+        next[k] += delta[k];
+        collectCell(cell, bbox_min, bbox_max, ids);
+    }
+
+    endQuery(ids);
+}
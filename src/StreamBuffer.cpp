@@ -0,0 +1,138 @@
+#include "StreamBuffer.h"
+
+#include <string.h>
+#include <algorithm>
+
+StreamBuffer::StreamBuffer(size_t frame_capacity, unsigned int frames)
+    : frames(std::max(frames, 1u)), segmentSize(frame_capacity), segment(0), frameBase(0), head(0),
+      fences(this->frames, (GLsync)0), grown(false), useFences(GLAD_GL_VERSION_3_2 != 0)
+{
+    glGenBuffers(1, &buffer_id);
+    orphan(this->frames * segmentSize);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    deleteFences();
+    glDeleteBuffers(1, &buffer_id);
+}
+
+// Memória nova para o buffer; o que a GPU ainda estiver lendo continua
+// válido para ela
+void StreamBuffer::orphan(size_t size)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
+    glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamBuffer::deleteFences()
+{
+    for (size_t i = 0; i < fences.size(); i++) {
+        if (fences[i] != 0)
+            glDeleteSync(fences[i]);
+        fences[i] = 0;
+    }
+}
+
+// O quadro atual precisa de "needed" bytes a partir de frameBase. Os
+// deslocamentos já entregues continuam valendo: a memória nova recebe de
+// volta o que o quadro escreveu, no mesmo lugar. Como glBufferData descarta
+// o conteúdo, esse trecho passa por um buffer temporário com
+// glCopyBufferSubData, sem voltar para a CPU. Os trechos são refeitos com o
+// novo tamanho no próximo endFrame().
+void StreamBuffer::grow(size_t needed)
+{
+    segmentSize = std::max(2 * segmentSize, needed);
+    size_t size = std::max(frames * segmentSize, frameBase + segmentSize);
+    deleteFences();
+    grown = true;
+    stats.grows++;
+
+    if (head == 0) {
+        orphan(size);
+        return;
+    }
+
+    GLuint saved;
+    glGenBuffers(1, &saved);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer_id);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, saved);
+    glBufferData(GL_COPY_WRITE_BUFFER, head, NULL, GL_STREAM_COPY);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, frameBase, 0, head);
+
+    glBufferData(GL_COPY_READ_BUFFER, size, NULL, GL_STREAM_DRAW);
+    glCopyBufferSubData(GL_COPY_WRITE_BUFFER, GL_COPY_READ_BUFFER, 0, frameBase, head);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &saved);
+}
+
+size_t StreamBuffer::write(const void* data, size_t bytes, size_t alignment)
+{
+    size_t start = (head + alignment - 1) / alignment * alignment;
+    if (start + bytes > segmentSize)
+        grow(start + bytes);
+
+    size_t offset = frameBase + start;
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
+    // Sem sincronização: ninguém mais lê este trecho (veja endFrame())
+    void* dst = glMapBufferRange(GL_ARRAY_BUFFER, offset, bytes,
+                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (dst != NULL) {
+        memcpy(dst, data, bytes);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    } else {
+        glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    head = start + bytes;
+
+    stats.bytes += bytes;
+    stats.writes++;
+    return offset;
+}
+
+void StreamBuffer::endFrame()
+{
+    lastFrame = stats;
+    stats = StreamStats();
+    head = 0;
+
+    if (grown) {
+        // os trechos mudaram de tamanho: recomeçamos do zero em memória nova
+        orphan(frames * segmentSize);
+        grown = false;
+        segment = 0;
+        frameBase = 0;
+        return;
+    }
+
+    if (useFences)
+        fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    segment = (segment + 1) % frames;
+    frameBase = segment * segmentSize;
+
+    bool busy;
+    if (useFences) {
+        // timeout 0: só consulta, nunca espera
+        GLsync fence = fences[segment];
+        GLenum status = fence != 0 ? glClientWaitSync(fence, 0, 0) : GL_ALREADY_SIGNALED;
+        busy = status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED;
+        if (!busy && fence != 0) {
+            glDeleteSync(fence);
+            fences[segment] = 0;
+        }
+    } else {
+        busy = segment == 0;
+    }
+
+    if (busy) {
+        orphan(frames * segmentSize);
+        deleteFences();
+        stats.orphans++;
+    }
+}
@@ -0,0 +1,466 @@
+#include "TextureCooker.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    float srgbToLinear(unsigned char value)
+    {
+        // Tabela calculada uma vez (estáticas locais são thread-safe)
+        struct Table
+        {
+            float values[256];
+            Table()
+            {
+                for (int i = 0; i < 256; i++) {
+                    float c = i / 255.0f;
+                    values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                }
+            }
+        };
+        static const Table table;
+        return table.values[value];
+    }
+
+    unsigned char linearToSrgb(float value)
+    {
+        value = std::min(std::max(value, 0.0f), 1.0f);
+        float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+        return (unsigned char)(c * 255.0f + 0.5f);
+    }
+
+    // Eixo principal (da maior variância) dos 16 texels de um bloco e a
+    // média deles. Retorna false se o bloco tem uma cor só.
+    bool principalAxis(const unsigned char* rgb, float mean[3], float axis[3])
+    {
+        mean[0] = mean[1] = mean[2] = 0.0f;
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < 3; c++)
+                mean[c] += rgb[3 * i + c];
+        for (int c = 0; c < 3; c++)
+            mean[c] /= 16.0f;
+
+        // rr rg rb gg gb bb
+        float cov[6] = { 0, 0, 0, 0, 0, 0 };
+        for (int i = 0; i < 16; i++) {
+            float r = rgb[3 * i + 0] - mean[0];
+            float g = rgb[3 * i + 1] - mean[1];
+            float b = rgb[3 * i + 2] - mean[2];
+            cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+            cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+        }
+        if (cov[0] + cov[3] + cov[5] < 1e-3f)
+            return false;
+
+        // Iteração de potência, começando pela diagonal de maior variância
+        float v[3] = { cov[0], cov[3], cov[5] };
+        for (int k = 0; k < 8; k++) {
+            float x = cov[0] * v[0] + cov[1] * v[1] + cov[2] * v[2];
+            float y = cov[1] * v[0] + cov[3] * v[1] + cov[4] * v[2];
+            float z = cov[2] * v[0] + cov[4] * v[1] + cov[5] * v[2];
+            float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+            if (length < 1e-8f)
+                return false;
+            v[0] = x / length; v[1] = y / length; v[2] = z / length;
+        }
+        float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        for (int c = 0; c < 3; c++)
+            axis[c] = v[c] / length;
+        return true;
+    }
+
+    // Extremos dos texels projetados no eixo principal
+    void axisEndpoints(const unsigned char* rgb, float e0[3], float e1[3])
+    {
+        float mean[3], axis[3];
+        if (!principalAxis(rgb, mean, axis)) {
+            for (int c = 0; c < 3; c++)
+                e0[c] = e1[c] = mean[c];
+            return;
+        }
+
+        float tmin = 1e30f, tmax = -1e30f;
+        for (int i = 0; i < 16; i++) {
+            float t = (rgb[3 * i] - mean[0]) * axis[0] + (rgb[3 * i + 1] - mean[1]) * axis[1]
+                    + (rgb[3 * i + 2] - mean[2]) * axis[2];
+            tmin = std::min(tmin, t);
+            tmax = std::max(tmax, t);
+        }
+        for (int c = 0; c < 3; c++) {
+            e0[c] = mean[c] + axis[c] * tmax;
+            e1[c] = mean[c] + axis[c] * tmin;
+        }
+    }
+
+    // Mínimos quadrados: as extremidades que melhor reproduzem os texels com
+    // os índices escolhidos, sendo "weights[i]" o peso de e1 no texel i
+    bool fitEndpoints(const unsigned char* rgb, const float* weights, float e0[3], float e1[3])
+    {
+        float aa = 0, ab = 0, bb = 0;
+        float ax[3] = { 0, 0, 0 }, bx[3] = { 0, 0, 0 };
+        for (int i = 0; i < 16; i++) {
+            float b = weights[i];
+            float a = 1.0f - b;
+            aa += a * a; ab += a * b; bb += b * b;
+            for (int c = 0; c < 3; c++) {
+                ax[c] += a * rgb[3 * i + c];
+                bx[c] += b * rgb[3 * i + c];
+            }
+        }
+        float det = aa * bb - ab * ab;
+        if (std::fabs(det) < 1e-6f)
+            return false;
+        for (int c = 0; c < 3; c++) {
+            e0[c] = std::min(std::max((bb * ax[c] - ab * bx[c]) / det, 0.0f), 255.0f);
+            e1[c] = std::min(std::max((aa * bx[c] - ab * ax[c]) / det, 0.0f), 255.0f);
+        }
+        return true;
+    }
+
+    int colorDistance(const int* a, const unsigned char* b)
+    {
+        int dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+        return dr * dr + dg * dg + db * db;
+    }
+
+    // ---- BC1
+
+    uint16_t pack565(const float color[3])
+    {
+        int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+        int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+        int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+        return (uint16_t)((std::min(r, 31) << 11) | (std::min(g, 63) << 5) | std::min(b, 31));
+    }
+
+    void unpack565(uint16_t value, int color[3])
+    {
+        int r = (value >> 11) & 31, g = (value >> 5) & 63, b = value & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // Escolhe os índices para as extremidades c0 > c1 (modo de 4 cores) e
+    // retorna o erro quadrático do bloco
+    int bc1Indices(const unsigned char* rgb, uint16_t c0, uint16_t c1, uint8_t* indices)
+    {
+        int palette[4][3];
+        unpack565(c0, palette[0]);
+        unpack565(c1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        int colors = c0 > c1 ? 4 : 1; // c0 == c1: todos os texels usam c0
+
+        int error = 0;
+        for (int i = 0; i < 16; i++) {
+            int best = 0, best_distance = colorDistance(palette[0], rgb + 3 * i);
+            for (int k = 1; k < colors; k++) {
+                int distance = colorDistance(palette[k], rgb + 3 * i);
+                if (distance < best_distance) {
+                    best = k;
+                    best_distance = distance;
+                }
+            }
+            indices[i] = (uint8_t)best;
+            error += best_distance;
+        }
+        return error;
+    }
+
+    int bc1Evaluate(const unsigned char* rgb, const float e0[3], const float e1[3],
+                    uint16_t* c0, uint16_t* c1, uint8_t* indices)
+    {
+        *c0 = pack565(e0);
+        *c1 = pack565(e1);
+        if (*c0 < *c1)
+            std::swap(*c0, *c1);
+        return bc1Indices(rgb, *c0, *c1, indices);
+    }
+
+    // ---- BC7 (modo 6)
+
+    const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // Extremidade de 7 bits por canal mais um bit P comum, que vira o bit
+    // menos significativo de todos os canais (o alfa fica em 254 ou 255)
+    struct BC7Endpoint
+    {
+        int q[3];
+        int p;
+        int value(int c) const { return (q[c] << 1) | p; }
+    };
+
+    BC7Endpoint quantizeBC7(const float color[3])
+    {
+        BC7Endpoint best;
+        float best_error = 1e30f;
+        for (int p = 0; p < 2; p++) {
+            BC7Endpoint e;
+            e.p = p;
+            float error = (float)((127 * 2 + p) - 255) * ((127 * 2 + p) - 255);
+            for (int c = 0; c < 3; c++) {
+                e.q[c] = std::min(std::max((int)((color[c] - p) / 2.0f + 0.5f), 0), 127);
+                float d = e.value(c) - color[c];
+                error += d * d;
+            }
+            if (error < best_error) {
+                best = e;
+                best_error = error;
+            }
+        }
+        return best;
+    }
+
+    int bc7Indices(const unsigned char* rgb, const BC7Endpoint& e0, const BC7Endpoint& e1, uint8_t* indices)
+    {
+        int palette[16][3];
+        for (int k = 0; k < 16; k++)
+            for (int c = 0; c < 3; c++)
+                palette[k][c] = ((64 - BC7_WEIGHTS[k]) * e0.value(c) + BC7_WEIGHTS[k] * e1.value(c) + 32) >> 6;
+
+        int error = 0;
+        for (int i = 0; i < 16; i++) {
+            int best = 0, best_distance = colorDistance(palette[0], rgb + 3 * i);
+            for (int k = 1; k < 16; k++) {
+                int distance = colorDistance(palette[k], rgb + 3 * i);
+                if (distance < best_distance) {
+                    best = k;
+                    best_distance = distance;
+                }
+            }
+            indices[i] = (uint8_t)best;
+            error += best_distance;
+        }
+        return error;
+    }
+
+    // Escreve campos de bits em um bloco de 128 bits, do bit menos
+    // significativo do byte 0 em diante
+    struct BitWriter
+    {
+        unsigned char* data;
+        int position;
+
+        void put(unsigned int value, int bits)
+        {
+            for (int i = 0; i < bits; i++, position++)
+                if (value & (1u << i))
+                    data[position >> 3] |= (unsigned char)(1u << (position & 7));
+        }
+    };
+
+    // Texels de um bloco, repetindo a última linha/coluna nas bordas
+    void gatherBlock(const unsigned char* rgb, int width, int height, int bx, int by, unsigned char* block)
+    {
+        for (int y = 0; y < 4; y++) {
+            int sy = std::min(by * 4 + y, height - 1);
+            for (int x = 0; x < 4; x++) {
+                int sx = std::min(bx * 4 + x, width - 1);
+                memcpy(block + 3 * (4 * y + x), rgb + 3 * ((size_t)sy * width + sx), 3);
+            }
+        }
+    }
+
+    void encodeLevel(const unsigned char* rgb, int width, int height, int format, unsigned char* out, JobSystem& jobs)
+    {
+        if (format == TEXTURE_RGB8) {
+            memcpy(out, rgb, 3 * (size_t)width * height);
+            return;
+        }
+
+        int blocks_x = (width + 3) / 4;
+        int blocks_y = (height + 3) / 4;
+        size_t block_bytes = format == TEXTURE_BC1 ? 8 : 16;
+        jobs.parallelFor(0, blocks_y, 4, [&](size_t begin, size_t end) {
+            unsigned char block[48];
+            for (size_t by = begin; by < end; by++) {
+                for (int bx = 0; bx < blocks_x; bx++) {
+                    gatherBlock(rgb, width, height, bx, (int)by, block);
+                    unsigned char* dst = out + (by * blocks_x + bx) * block_bytes;
+                    if (format == TEXTURE_BC1)
+                        encodeBC1Block(block, dst);
+                    else
+                        encodeBC7Block(block, dst);
+                }
+            }
+        });
+    }
+}
+
+int textureLevelCount(int width, int height)
+{
+    int levels = 1;
+    while (width > 1 || height > 1) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        levels++;
+    }
+    return levels;
+}
+
+size_t textureLevelBytes(int format, int width, int height)
+{
+    if (format == TEXTURE_RGB8)
+        return 3 * (size_t)width * height;
+    size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+    return blocks * (format == TEXTURE_BC1 ? 8 : 16);
+}
+
+int cookTexture(const unsigned char* rgb, int width, int height, int format,
+                std::vector<unsigned char>* out, JobSystem& jobs)
+{
+    int levels = textureLevelCount(width, height);
+    size_t total = 0;
+    for (int level = 0, w = width, h = height; level < levels; level++) {
+        total += textureLevelBytes(format, w, h);
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+    size_t offset = out->size();
+    out->resize(offset + total);
+    unsigned char* dst = out->data() + offset;
+
+    encodeLevel(rgb, width, height, format, dst, jobs);
+    dst += textureLevelBytes(format, width, height);
+    if (levels == 1)
+        return levels;
+
+    std::vector<float> linear(3 * (size_t)width * height);
+    for (size_t i = 0; i < linear.size(); i++)
+        linear[i] = srgbToLinear(rgb[i]);
+
+    std::vector<float> next;
+    std::vector<unsigned char> level_rgb;
+    int w = width, h = height;
+    for (int level = 1; level < levels; level++) {
+        int nw = std::max(1, w / 2);
+        int nh = std::max(1, h / 2);
+        next.resize(3 * (size_t)nw * nh);
+        level_rgb.resize(next.size());
+
+        // Caixa 2x2 em espaço linear; em dimensões ímpares a última
+        // coluna/linha é repetida
+        jobs.parallelFor(0, nh, 16, [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; y++) {
+                const float* row0 = &linear[3 * (size_t)w * std::min(2 * (int)y, h - 1)];
+                const float* row1 = &linear[3 * (size_t)w * std::min(2 * (int)y + 1, h - 1)];
+                for (int x = 0; x < nw; x++) {
+                    int x0 = 3 * std::min(2 * x, w - 1);
+                    int x1 = 3 * std::min(2 * x + 1, w - 1);
+                    for (int c = 0; c < 3; c++) {
+                        size_t i = 3 * (y * nw + x) + c;
+                        next[i] = 0.25f * (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]);
+                        level_rgb[i] = linearToSrgb(next[i]);
+                    }
+                }
+            }
+        });
+
+        encodeLevel(level_rgb.data(), nw, nh, format, dst, jobs);
+        dst += textureLevelBytes(format, nw, nh);
+
+        linear.swap(next);
+        w = nw;
+        h = nh;
+    }
+    return levels;
+}
+
+// Extremidades no eixo principal, depois dois ajustes por mínimos quadrados
+// com os índices encontrados; fica o de menor erro
+void encodeBC1Block(const unsigned char* rgb, unsigned char* block)
+{
+    float e0[3], e1[3];
+    axisEndpoints(rgb, e0, e1);
+
+    uint16_t c0, c1;
+    uint8_t indices[16];
+    int error = bc1Evaluate(rgb, e0, e1, &c0, &c1, indices);
+
+    for (int iteration = 0; iteration < 2 && error > 0; iteration++) {
+        const float palette_weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+        float weights[16];
+        for (int i = 0; i < 16; i++)
+            weights[i] = palette_weights[indices[i]];
+        if (!fitEndpoints(rgb, weights, e0, e1))
+            break;
+
+        uint16_t n0, n1;
+        uint8_t n_indices[16];
+        int n_error = bc1Evaluate(rgb, e0, e1, &n0, &n1, n_indices);
+        if (n_error >= error)
+            break;
+        c0 = n0;
+        c1 = n1;
+        memcpy(indices, n_indices, 16);
+        error = n_error;
+    }
+
+    uint32_t bits = 0;
+    for (int i = 0; i < 16; i++)
+        bits |= (uint32_t)indices[i] << (2 * i);
+    block[0] = (unsigned char)(c0 & 0xFF);
+    block[1] = (unsigned char)(c0 >> 8);
+    block[2] = (unsigned char)(c1 & 0xFF);
+    block[3] = (unsigned char)(c1 >> 8);
+    for (int i = 0; i < 4; i++)
+        block[4 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+// Modo 6: mesma busca de BC1, com extremidades de 7 bits + P e 16 níveis
+void encodeBC7Block(const unsigned char* rgb, unsigned char* block)
+{
+    float f0[3], f1[3];
+    axisEndpoints(rgb, f0, f1);
+
+    BC7Endpoint e0 = quantizeBC7(f0), e1 = quantizeBC7(f1);
+    uint8_t indices[16];
+    int error = bc7Indices(rgb, e0, e1, indices);
+
+    for (int iteration = 0; iteration < 2 && error > 0; iteration++) {
+        float weights[16];
+        for (int i = 0; i < 16; i++)
+            weights[i] = BC7_WEIGHTS[indices[i]] / 64.0f;
+        if (!fitEndpoints(rgb, weights, f0, f1))
+            break;
+
+        BC7Endpoint n0 = quantizeBC7(f0), n1 = quantizeBC7(f1);
+        uint8_t n_indices[16];
+        int n_error = bc7Indices(rgb, n0, n1, n_indices);
+        if (n_error >= error)
+            break;
+        e0 = n0;
+        e1 = n1;
+        memcpy(indices, n_indices, 16);
+        error = n_error;
+    }
+
+    // O bit mais significativo do índice do texel 0 não é gravado: precisa
+    // ser zero, senão as extremidades são trocadas
+    if (indices[0] & 8) {
+        std::swap(e0, e1);
+        for (int i = 0; i < 16; i++)
+            indices[i] = (uint8_t)(15 - indices[i]);
+    }
+
+    memset(block, 0, 16);
+    BitWriter writer = { block, 0 };
+    writer.put(1u << 6, 7); // modo 6
+    for (int c = 0; c < 3; c++) {
+        writer.put(e0.q[c], 7);
+        writer.put(e1.q[c], 7);
+    }
+    writer.put(127, 7); // alfa
+    writer.put(127, 7);
+    writer.put(e0.p, 1);
+    writer.put(e1.p, 1);
+    writer.put(indices[0], 3);
+    for (int i = 1; i < 16; i++)
+        writer.put(indices[i], 4);
+}
@@ -0,0 +1,85 @@
+#include "Trajectory.h"
+
+#include <algorithm>
+#include <math.h>
+#include <glm/common.hpp>
+
+Trajectory::Trajectory()
+    : a(0.0f), b(0.0f), c(0.0f), d(0.0f)
+{
+    //ctor
+}
+
+Trajectory::Trajectory(glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 d)
+    : a(a), b(b), c(c), d(d)
+{
+    //ctor
+}
+
+Trajectory::~Trajectory()
+{
+    //dtor
+}
+
+// Expandindo os polinômios de Bernstein:
+//   (1-t)^3 P0 + 3t(1-t)^2 P1 + 3t^2(1-t) P2 + t^3 P3
+Trajectory Trajectory::fromBezier(glm::vec4 p0, glm::vec4 p1, glm::vec4 p2, glm::vec4 p3)
+{
+    glm::vec3 P0(p0), P1(p1), P2(p2), P3(p3);
+    return Trajectory(P3 - 3.0f*P2 + 3.0f*P1 - P0,
+                      3.0f*P2 - 6.0f*P1 + 3.0f*P0,
+                      3.0f*P1 - 3.0f*P0,
+                      P0);
+}
+
+glm::vec4 Trajectory::position(float t) const
+{
+    return glm::vec4(((a*t + b)*t + c)*t + d, 1.0f);
+}
+
+glm::vec4 Trajectory::velocity(float t) const
+{
+    return glm::vec4((3.0f*a*t + 2.0f*b)*t + c, 0.0f);
+}
+
+void Trajectory::bounds(float t0, float t1, glm::vec3& bbox_min, glm::vec3& bbox_max) const
+{
+    if (t1 < t0)
+        std::swap(t0, t1);
+
+    glm::vec3 p0 = glm::vec3(position(t0));
+    glm::vec3 p1 = glm::vec3(position(t1));
+    bbox_min = glm::min(p0, p1);
+    bbox_max = glm::max(p0, p1);
+
+    // Os extremos internos de cada eixo estão nas raízes da derivada
+    //   3a t^2 + 2b t + c = 0
+    for (int axis = 0; axis < 3; axis++) {
+        float A = 3.0f * a[axis];
+        float B = 2.0f * b[axis];
+        float C = c[axis];
+
+        float roots[2];
+        int num_roots = 0;
+        if (fabs(A) < 1e-12f) {
+            if (fabs(B) > 1e-12f)
+                roots[num_roots++] = -C / B;
+        } else {
+            float delta = B*B - 4.0f*A*C;
+            if (delta >= 0.0f) {
+                float sq = sqrt(delta);
+                roots[num_roots++] = (-B + sq) / (2.0f*A);
+                roots[num_roots++] = (-B - sq) / (2.0f*A);
+            }
+        }
+
+        for (int r = 0; r < num_roots; r++) {
+            float t = roots[r];
+            if (t > t0 && t < t1) {
+                float value = ((a[axis]*t + b[axis])*t + c[axis])*t + d[axis];
+                bbox_min[axis] = std::min(bbox_min[axis], value);
+                bbox_max[axis] = std::max(bbox_max[axis], value);
+            }
+        }
+    }
+}
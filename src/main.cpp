@@ -11,14 +11,22 @@
 //                   Mario Figueiró
 
 #include <cmath>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cerrno>
+#include <climits>
 #include <ctime>
+#include <chrono>
 
 #include <map>
 #include <stack>
 #include <string>
 #include <vector>
+#include <memory>
+#include <thread>
 #include <limits>
 #include <fstream>
 #include <sstream>
@@ -32,6 +40,7 @@
 #include <glm/mat4x4.hpp>
 #include <glm/vec4.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include <tiny_obj_loader.h>
 #include <stb_image.h>
@@ -43,40 +52,103 @@
 #include "shader.h"
 
 // model
-#include "Spaceship.h"
-#include "Asteroid.h"
-#include "Player.h"
+#include "GameWorld.h"
 #include "obj_model.h"
-#include "bullet.h"
-
-/// Configurations
-#define MAX_ASTEROIDS 35
-#define ASTEROIDS_SPAWN_DISTANCE 20 // distance relative to spaceship
-#define ASTEROIDS_DESTROY_DISTANCE 25 // distance relative to spaceship
+#include "RenderQueue.h"
+#include "Frustum.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "MeshCache.h"
+#include "FrameUniforms.h"
+#include "StreamBuffer.h"
+#include "AssetQueue.h"
+#include "TextureCooker.h"
 
 #define SPACESHIP 0
 #define ASTEROID  1
 #define BULLET    2
 
-#define PHI_MAX 1.570796f
-#define PHI_MIN -1.570796f
-#define THETA_MAX 3.1415f
-#define THETA_MIN -3.1415f
-
-unsigned int loadCubemap(std::vector<std::string> faces);
-Asteroid generateNewAsteroid();
+// Níveis de detalhe (LOD): o nível 0 é a malha original e cada nível
+// seguinte tem 1/LOD_TRIANGLE_RATIO dos triângulos do anterior. O nível k é
+// usado enquanto o objeto ocupar pelo menos LOD_SCREEN_SIZE[k] da metade da
+// altura da tela; LOD_HYSTERESIS é a folga, em fração do limiar, antes de
+// trocar de nível, para que um objeto na fronteira não fique alternando.
+#define MAX_LODS           4
+#define LOD_TRIANGLE_RATIO 4
+#define LOD_HYSTERESIS     0.15f
+const float LOD_SCREEN_SIZE[MAX_LODS - 1] = { 0.25f, 0.10f, 0.04f };
+
+// Bytes por quadro reservados inicialmente para dados dinâmicos (instâncias
+// e texto); o StreamBuffer cresce se precisar
+#define STREAM_BUFFER_CAPACITY (256 * 1024)
+
+// Tempo por quadro, em segundos, para enviar assets carregados à GPU (veja
+// AssetQueue::update())
+#define ASSET_UPLOAD_BUDGET 0.002
+
+// Formatos comprimidos de extensões (S3TC, sRGB e BPTC), que "glad.h" não
+// define por carregar só o núcleo do OpenGL 3.3
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT         0x83F0
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT        0x8C4C
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM           0x8E8C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM     0x8E8D
+#endif
+
+std::vector<std::string> CubemapFaces(const std::string& directory); // As seis imagens de um cube map, na ordem do OpenGL
+void loadCubemap(AssetQueue& assets, const std::vector<std::string>& faces, GLuint* texture, bool use_cache = true); // Carrega as texturas do cube map em segundo plano
 void gameOver();
-bool testInterseption(Asteroid asteroid, Spaceship spaceship, glm::mat4 model);
-bool testInterseption(Asteroid asteroid1, Asteroid asteroid2);
-bool testInterseption(Asteroid asteroid, bullet b);
+void PrintUsage(const char* program); // Mostra os argumentos de linha de comando aceitos
+bool ParseUnsigned(const char* text, unsigned long max, unsigned long* value); // Número decimal sem sinal, até "max"
+int RunHeadless(unsigned long ticks, unsigned int seed, size_t max_asteroids, unsigned int threads); // Simulação sem janela nem OpenGL
+std::vector<glm::vec4> CollectModelVertices(ObjModel* model); // Vértices de todos os triângulos de um ObjModel
+
+// Identificador de um objeto em g_VirtualScene (índice no vetor)
+typedef uint32_t MeshId;
+
+// Imagem RGB (8 bits por canal) mantida na memória, para amostrar texturas
+// na CPU. A linha 0 é a de v = 0, como na GPU.
+struct ImageRGB
+{
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> texels;
+};
 
 // Declaração de várias funções utilizadas em main().  Essas estão definidas
 // logo após a definição de main() neste arquivo.
-void BuildTrianglesAndAddToVirtualScene(ObjModel*); // Constrói representação de um ObjModel como malha de triângulos para renderização
+struct MeshData;
+struct MeshView;
+void LoadModel(AssetQueue& assets, const char* filename, const char* basepath = NULL, const char* albedo_filename = NULL, unsigned int options = 0, std::vector<glm::vec4>* collision = NULL); // Carrega um modelo (do cache, se possível) para g_VirtualScene, em segundo plano
+MeshView LoadMeshData(const char* filename, const char* basepath, const char* albedo_filename, unsigned int options, MeshCacheFile* cache, MeshData* data); // Modelo processado, do cache ou do ".obj"
+void BuildMesh(ObjModel* model, const ImageRGB* spherical_albedo, unsigned int options, MeshData* mesh); // Constrói representação de um ObjModel como malha de triângulos para renderização
+MeshId AddMeshToVirtualScene(const MeshView& mesh); // Envia um modelo processado para a GPU
+MeshId FindVirtualObject(const char* object_name); // Busca um objeto pelo nome (só no carregamento)
+void GenerateLevelsOfDetail(ObjModel* model, const std::vector<GLuint>& corner_vertices, MeshData* mesh); // Gera versões simplificadas dos objetos de um ObjModel
+GLuint CloneVertexArray(GLuint source, GLuint element_buffer); // Novo VAO com os mesmos atributos de outro
+int SelectLevelOfDetail(float screen_size, int current, int num_lods); // Nível de detalhe para um tamanho na tela
 void ComputeNormals(ObjModel* model); // Computa normais de um ObjModel, caso não existam.
 void LoadShadersFromFiles(); // Carrega os shaders de vértice e fragmento, criando um programa de GPU
-void LoadTextureImage(const char* filename); // Função que carrega imagens de textura
-void DrawVirtualObject(const char* object_name); // Desenha um objeto armazenado em g_VirtualScene
+struct CookedTexture;
+void LoadTextureImage(AssetQueue& assets, const char* filename, bool use_cache = true); // Função que carrega imagens de textura, em segundo plano
+void UploadTextureImage(const CookedTexture& texture, GLuint textureunit); // Envia uma textura preparada para a GPU
+int SelectTextureFormat(const std::string& requested); // Formato de textura (TEXTURE_*) mais compacto que a GPU aceita
+void LoadCookedTexture(const std::vector<std::string>& filenames, int format, bool use_cache, CookedTexture* texture); // Imagens com mipmaps e comprimidas, do cache ou do disco
+void UploadCookedImage(GLenum target, const CookedTexture& texture, int image, bool srgb); // Envia todos os níveis de uma imagem de CookedTexture
+void UploadMaterials(Shader& shader); // Envia g_Materials para os arrays "materials_*" do shader
+void LoadImageRGB(const char* filename, ImageRGB* image); // Lê uma imagem do disco, sem enviar para a GPU
+glm::vec3 SampleImageBilinear(const ImageRGB& image, glm::vec2 uv); // Amostra uma imagem sRGB como a GPU faria
+uint8_t LinearToGamma8(float value); // Codifica uma cor linear com gamma 2.2 em 8 bits
+glm::vec2 SphericalMapping(const glm::vec3& center, const glm::vec3& position); // Coordenadas de textura (U,V) por projeção esférica
+DrawItem VirtualObjectDrawItem(MeshId mesh, int object_id, int lod = 0); // Desenho de um objeto armazenado em g_VirtualScene, para a RenderQueue
+void AttachInstanceAttributes(GLuint vertex_array_object_id); // Habilita os atributos por instância de um VAO
+void UploadInstances(GLuint vertex_array_object_id, const std::vector<glm::mat4>& models); // Envia as matrizes "model" das cópias de um objeto para a GPU
 GLuint LoadShader_Vertex(const char* filename);   // Carrega um vertex shader
 GLuint LoadShader_Fragment(const char* filename); // Carrega um fragment shader
 void LoadShader(const char* filename, GLuint shader_id); // Função utilizada pelas duas acima
@@ -84,7 +156,7 @@ void LoadShader(const char* filename, GLuint shader_id); // Função utilizada p
 
 // Declaração de funções auxiliares para renderizar texto dentro da janela
 // OpenGL. Estas funções estão definidas no arquivo "textrendering.cpp".
-void TextRendering_Init();
+void TextRendering_Init(StreamBuffer* stream);
 float TextRendering_LineHeight(GLFWwindow* window);
 float TextRendering_CharWidth(GLFWwindow* window);
 void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float x, float y, float scale = 1.0f);
@@ -94,6 +166,10 @@ void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float
 void TextRendering_ShowFramesPerSecond(GLFWwindow* window);
 void TextRendering_ShowSpaceshipLife(GLFWwindow* window);
 void TextRendering_ShowPlayerInfo(GLFWwindow* window);
+void TextRendering_ShowRenderStats(GLFWwindow* window, const RenderStats& stats);
+void TextRendering_ShowCullStats(GLFWwindow* window, size_t visible, size_t culled);
+void TextRendering_ShowStreamStats(GLFWwindow* window, const StreamStats& stats);
+void TextRendering_ShowLoadingProgress(GLFWwindow* window, size_t loaded, size_t total);
 
 // Funções callback para comunicação com o sistema operacional e interação do
 // usuário. Veja mais comentários nas definições das mesmas, abaixo.
@@ -104,21 +180,168 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 void CursorPosCallback(GLFWwindow* window, double xpos, double ypos);
 void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 
+// Um nível de detalhe de um SceneObject. Cada nível tem seu próprio VAO
+// (com os mesmos atributos de vértice) para poder ter seu próprio buffer de
+// instâncias.
+struct LevelOfDetail
+{
+    GLuint       vertex_array_object_id;
+    size_t       first_index;
+    size_t       num_indices;
+};
+
 // Definimos uma estrutura que armazenará dados necessários para renderizar
 // cada objeto da cena virtual.
 struct SceneObject
 {
-    std::string  name;        // Nome do objeto
-    size_t       first_index; // Índice do primeiro vértice dentro do vetor indices[] definido em BuildTrianglesAndAddToVirtualScene()
-    size_t       num_indices; // Número de índices do objeto dentro do vetor indices[] definido em BuildTrianglesAndAddToVirtualScene()
+    size_t       first_index; // Índice do primeiro vértice dentro do vetor MeshData::indices gerado em BuildMesh()
+    size_t       num_indices; // Número de índices do objeto dentro do vetor MeshData::indices gerado em BuildMesh()
     GLenum       rendering_mode; // Modo de rasterização (GL_TRIANGLES, GL_TRIANGLE_STRIP, etc.)
     GLuint       vertex_array_object_id; // ID do VAO onde estão armazenados os atributos do modelo
     glm::vec3    bbox_min; // Axis-Aligned Bounding Box do objeto
     glm::vec3    bbox_max;
-    std::vector<glm::vec4> vertices;
+    float        bounding_radius; // Raio da esfera centrada na origem do modelo que contém a AABB
+    int          material_base; // somado ao material dos vértices para indexar g_Materials
+    std::vector<LevelOfDetail> lods; // lods[0] é o próprio objeto; veja GenerateLevelsOfDetail()
+};
+
+// Formato dos vértices na GPU: um só VBO por modelo, com os atributos
+// intercalados e compactados (24 bytes, em vez de 88 com um VBO de floats
+// por atributo). As constantes do material não se repetem em cada vértice;
+// ficam em g_Materials e o vértice guarda só o índice.
+struct PackedVertex
+{
+    float    position[3]; // "(location = 0)"
+    uint32_t normal;      // "(location = 1)", GL_INT_2_10_10_10_REV normalizado
+    uint32_t texcoords;   // "(location = 2)", dois half floats
+    uint8_t  color[3];    // "(location = 3)", cor do vértice com gamma 2.2 (albedo dos asteroides)
+    uint8_t  material;    // "(location = 4)", material do modelo (0 = nenhum); veja SceneObject::material_base
+};
+static_assert(sizeof(PackedVertex) == 24, "PackedVertex deve ter 24 bytes");
+
+// Constantes de um material de arquivo .mtl. Veja UploadMaterials().
+#define MAX_MATERIALS 64 // igual ao de "shader_vertex.glsl"
+struct Material
+{
+    glm::vec4 Kd = glm::vec4(0.0f); // refletância difusa
+    glm::vec4 Ks = glm::vec4(0.0f); // refletância especular; w = expoente especular
+    glm::vec4 Ka = glm::vec4(0.0f); // refletância ambiente
+};
+
+// Materiais de todos os modelos carregados; o material 0 (tudo zero) é o
+// dos vértices sem material
+std::vector<Material> g_Materials(1);
+
+// Uma shape de um modelo processado por BuildMesh()
+#define MESH_SHAPE_NAME_SIZE 128
+struct MeshShape
+{
+    char      name[MESH_SHAPE_NAME_SIZE];
+    uint32_t  first_index;
+    uint32_t  num_indices;
+    glm::vec3 bbox_min;
+    glm::vec3 bbox_max;
+};
+
+// Um nível de detalhe de uma shape: um trecho de MeshData::lod_indices
+struct MeshLevel
+{
+    uint32_t shape;
+    uint32_t first_index;
+    uint32_t num_indices;
+};
+
+// Um modelo processado por BuildMesh(), pronto para ir para a GPU. Os
+// materiais dos vértices são do modelo: 0 = nenhum, k = materials[k-1].
+struct MeshData
+{
+    std::vector<PackedVertex> vertices;
+    std::vector<GLuint>       indices;
+    std::vector<MeshShape>    shapes;
+    std::vector<Material>     materials;
+    std::vector<GLuint>       lod_indices;
+    std::vector<MeshLevel>    levels;
+    std::vector<glm::vec4>    collision; // 3 vértices por triângulo; veja CollectModelVertices()
 };
 
-std::map<std::string, SceneObject> g_VirtualScene;
+// Trecho de memória somente leitura com "size" elementos
+template <typename T>
+struct ConstArray
+{
+    const T* data;
+    size_t   size;
+
+    ConstArray() : data(NULL), size(0) {}
+    ConstArray(const std::vector<T>& values) : data(values.empty() ? NULL : &values[0]), size(values.size()) {}
+    const T& operator[](size_t i) const { return data[i]; }
+};
+
+// Os mesmos dados de um MeshData, sem dono: apontam para um MeshData ou
+// direto para um MeshCacheFile mapeado na memória
+struct MeshView
+{
+    ConstArray<PackedVertex> vertices;
+    ConstArray<GLuint>       indices;
+    ConstArray<MeshShape>    shapes;
+    ConstArray<Material>     materials;
+    ConstArray<GLuint>       lod_indices;
+    ConstArray<MeshLevel>    levels;
+    ConstArray<glm::vec4>    collision;
+};
+
+// Opções de LoadModel() e LoadMeshData()
+#define MESH_LEVELS_OF_DETAIL 1 // gera versões simplificadas; veja GenerateLevelsOfDetail()
+#define MESH_COLLISION        2 // guarda os triângulos para colisão
+
+// Aumente sempre que PackedVertex, MeshShape, MeshLevel, Material ou o
+// processamento em BuildMesh() mudarem: os caches antigos são descartados
+#define MESH_CACHE_VERSION 1
+
+// Blocos do cache de um modelo (veja "MeshCache.h")
+#define MESH_CHUNK_VERTICES    MESH_CACHE_ID('V','E','R','T')
+#define MESH_CHUNK_INDICES     MESH_CACHE_ID('I','N','D','X')
+#define MESH_CHUNK_SHAPES      MESH_CACHE_ID('S','H','A','P')
+#define MESH_CHUNK_MATERIALS   MESH_CACHE_ID('M','A','T','L')
+#define MESH_CHUNK_LOD_INDICES MESH_CACHE_ID('L','O','D','I')
+#define MESH_CHUNK_LEVELS      MESH_CACHE_ID('L','O','D','S')
+#define MESH_CHUNK_COLLISION   MESH_CACHE_ID('C','O','L','L')
+
+// Aumente sempre que o formato do cache de texturas ou o processamento em
+// cookTexture() mudarem
+#define TEXTURE_CACHE_VERSION 1
+
+// Blocos do cache de uma textura (veja LoadCookedTexture()): formato e
+// dimensões e, para cada imagem (uma, ou as seis faces de um cube map),
+// todos os níveis de mipmap em sequência
+#define TEXTURE_CHUNK_INFO     MESH_CACHE_ID('T','E','X','I')
+#define TEXTURE_CHUNK_IMAGE(i) MESH_CACHE_ID('I','M','G','0' + (i))
+
+// Uma textura pronta para a GPU: os níveis de cada imagem apontam para o
+// cache mapeado na memória ou para "cooked"
+struct CookedTexture
+{
+    MeshCacheFile cache;
+    std::vector<unsigned char> cooked[6];
+    const unsigned char* images[6];
+    int32_t info[4]; // formato (TEXTURE_*), largura, altura, níveis
+};
+
+// Formato (TEXTURE_*) das texturas enviadas à GPU, escolhido em main() por
+// SelectTextureFormat() antes de qualquer carregamento
+int g_TextureFormat = TEXTURE_RGB8;
+
+// Todos os objetos da cena, em um vetor contíguo indexado por MeshId. Os
+// nomes só são consultados no carregamento, com FindVirtualObject(); o laço
+// de renderização guarda os MeshId.
+std::vector<SceneObject> g_VirtualScene;
+std::map<std::string, MeshId> g_VirtualSceneNames;
+
+// Dados que mudam a cada quadro: as matrizes "model" das instâncias (veja
+// UploadInstances()) e o texto
+StreamBuffer* g_StreamBuffer = NULL;
+
+// Threads que interpretam os ".obj" em paralelo; veja loadObjParallel()
+JobSystem* g_LoaderJobs = NULL;
 
 // Razão de proporção da janela (largura/altura). Veja função FramebufferSizeCallback().
 float g_ScreenRatio = 1.0f;
@@ -146,37 +369,104 @@ bool g_ShowInfoText = true;
 // Variáveis que definem um programa de GPU (shaders). Veja função LoadShadersFromFiles().
 GLuint vertex_shader_id;
 GLuint fragment_shader_id;
-GLint model_uniform;
-GLint view_uniform;
-GLint projection_uniform;
-GLint object_id_uniform;
-GLint need_texture_uniform;
-GLint bbox_min_uniform;
-GLint bbox_max_uniform;
+GLuint g_ObjectsProgram; // O programa dos objetos, para a RenderQueue
+RenderUniforms g_ObjectUniforms; // Uniforms desse programa alterados pela RenderQueue
 
 // Número de texturas carregadas pela função LoadTextureImage()
 GLuint g_NumLoadedTextures = 0;
 
 ///////////////////////////////////
-// Lógica do jogo
-Player player = Player();
-Spaceship spaceship = Spaceship();
-std::vector<Asteroid> asteroids;
-std::vector<bullet> bullets;
+// Lógica do jogo. Veja GameWorld.h
+GameWorld* g_World = NULL;
 
 // timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-// events
-bool leftKeyPressed = false;
-bool rightKeyPressed = false;
-bool topKeyPressed = false;
-bool downKeyPressed = false;
-bool spacePressed = false;
-
 int main(int argc, char* argv[])
 {
+    // Argumentos de linha de comando:
+    //   --headless     roda somente a simulação, sem janela nem OpenGL
+    //   --ticks N      número de ticks simulados no modo headless
+    //   --seed S       semente para geração dos asteroides
+    //   --asteroids N  número máximo de asteroides simultâneos
+    //   --threads N    threads da simulação e do carregamento (0 = uma por núcleo)
+    //   --skybox NOME  cube map de "data/cubesmaps/NOME" (p.ex. simple, blue)
+    //   --no-texture-cache  sempre decodifica e comprime as imagens de textura
+    //   --texture-format F  rgb, bc1 ou bc7 (padrão: o mais compacto aceito pela GPU)
+    //   arquivo.obj    modelo extra carregado na cena (modo com janela)
+    bool headless = false;
+    unsigned long ticks = 10000;
+    unsigned int seed = time(NULL);
+    size_t max_asteroids = MAX_ASTEROIDS;
+    unsigned int threads = 0;
+    const char* extra_model = NULL;
+    std::string skybox = "simple";
+    bool texture_cache = true;
+    std::string texture_format;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool takes_value = arg == "--ticks" || arg == "--seed" || arg == "--asteroids" || arg == "--threads"
+                        || arg == "--skybox" || arg == "--texture-format";
+        if (takes_value && i+1 >= argc)
+        {
+            fprintf(stderr, "ERROR: missing value for %s.\n", arg.c_str());
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        unsigned long number = 0;
+        bool is_number = arg == "--ticks" || arg == "--seed" || arg == "--asteroids" || arg == "--threads";
+        if (is_number && !ParseUnsigned(argv[i+1], arg == "--seed" || arg == "--threads" ? UINT_MAX : ULONG_MAX, &number))
+        {
+            fprintf(stderr, "ERROR: invalid value \"%s\" for %s.\n", argv[i+1], arg.c_str());
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        if (is_number)
+            i++;
+
+        if (arg == "--headless")
+            headless = true;
+        else if (arg == "--ticks")
+            ticks = number;
+        else if (arg == "--seed")
+            seed = number;
+        else if (arg == "--asteroids")
+            max_asteroids = number;
+        else if (arg == "--threads")
+            threads = number;
+        else if (arg == "--skybox")
+            skybox = argv[++i];
+        else if (arg == "--no-texture-cache")
+            texture_cache = false;
+        else if (arg == "--texture-format")
+            texture_format = argv[++i];
+        else if (arg.compare(0, 2, "--") == 0 || extra_model != NULL)
+        {
+            fprintf(stderr, "ERROR: unknown argument \"%s\".\n", arg.c_str());
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        else
+            extra_model = argv[i];
+    }
+
+    // Todas as imagens são lidas com a linha de baixo primeiro, como o
+    // OpenGL espera. A opção é global em stb_image, então é definida uma
+    // vez, antes de qualquer carregamento em outra thread.
+    stbi_set_flip_vertically_on_load(true);
+
+    if (headless)
+        return RunHeadless(ticks, seed, max_asteroids, threads);
+
+    // Só o modo com janela carrega assets. Pelo menos uma thread além desta,
+    // para que o carregamento não a bloqueie (veja AssetQueue)
+    unsigned int loader_threads = threads != 0 ? threads : std::thread::hardware_concurrency();
+    JobSystem loader_jobs(std::max(2u, loader_threads));
+    g_LoaderJobs = &loader_jobs;
+
     // Inicializamos a biblioteca GLFW, utilizada para criar uma janela do
     // sistema operacional, onde poderemos renderizar com OpenGL.
     int success = glfwInit();
@@ -186,9 +476,6 @@ int main(int argc, char* argv[])
         std::exit(EXIT_FAILURE);
     }
 
-    // start rand numbers
-    srand(time(NULL));
-
     // Definimos o callback para impressão de erros da GLFW no terminal
     glfwSetErrorCallback(ErrorCallback);
 
@@ -246,50 +533,61 @@ int main(int argc, char* argv[])
 
     printf("GPU: %s, %s, OpenGL %s, GLSL %s\n", vendor, renderer, glversion, glslversion);
 
+    g_TextureFormat = SelectTextureFormat(texture_format);
+
+    // Dados que mudam a cada quadro e texto; o texto já é usado na tela de
+    // carregamento
+    StreamBuffer stream_buffer(STREAM_BUFFER_CAPACITY);
+    g_StreamBuffer = &stream_buffer;
+    TextRendering_Init(&stream_buffer);
+
+    // Os assets são carregados em segundo plano (veja AssetQueue): as
+    // threads de trabalho leem e processam os arquivos enquanto esta thread
+    // compila os shaders e mostra a tela de carregamento, enviando para a
+    // GPU, a cada quadro, o que já ficou pronto.
+    AssetQueue assets(loader_jobs);
+    double load_start = glfwGetTime();
+
+    // Carregamos duas imagens para serem utilizadas como textura
+    LoadTextureImage(assets, "../../data/texture/steel.jpg", texture_cache); // TextureImage0
+
+    // Construímos a representação de objetos geométricos através de malhas
+    // de triângulos. Os ".obj" só são interpretados na primeira execução;
+    // nas seguintes o resultado vem de um cache binário (veja LoadMeshData()).
+    // A textura dos asteroides só é usada nesse processamento: a cor de cada
+    // vértice é amostrada dela uma vez (veja BuildMesh()).
+    std::vector<glm::vec4> spaceship_triangles;
+    LoadModel(assets, "../../data/SpaceShip.obj", "../../data/", NULL, MESH_COLLISION, &spaceship_triangles);
+    LoadModel(assets, "../../data/bullet.obj", "../../data/");
+    LoadModel(assets, "../../data/asteroid.obj", "../../data/", "../../data/texture/basalt.jpg", MESH_LEVELS_OF_DETAIL);
+    if ( extra_model != NULL )
+        LoadModel(assets, extra_model);
+
+    // Carrega as imagens do Cube map
+    std::vector<std::string> faces = CubemapFaces("../../data/cubesmaps/" + skybox + "/");
+    GLuint cubemapTexture = 0;
+    loadCubemap(assets, faces, &cubemapTexture, texture_cache);
+
     // Carregamos os shaders de vértices e de fragmentos que serão utilizados
     // para renderização. Veja slides 217-219 do documento "Aula_03_Rendering_Pipeline_Grafico.pdf".
     //
 
     Shader objectsShader("../../src/shaders/shader_vertex.glsl", "../../src/shaders/shader_fragment.glsl");
-    model_uniform           = glGetUniformLocation(objectsShader.ID, "model"); // Variável da matriz "model"
-    view_uniform            = glGetUniformLocation(objectsShader.ID, "view"); // Variável da matriz "view" em shader_vertex.glsl
-    projection_uniform      = glGetUniformLocation(objectsShader.ID, "projection"); // Variável da matriz "projection" em shader_vertex.glsl
-    object_id_uniform       = glGetUniformLocation(objectsShader.ID, "object_id"); // Variável "object_id" em shader_fragment.glsl
-    need_texture_uniform    = glGetUniformLocation(objectsShader.ID, "need_texture");
-    bbox_min_uniform        = glGetUniformLocation(objectsShader.ID, "bbox_min");
-    bbox_max_uniform        = glGetUniformLocation(objectsShader.ID, "bbox_max");
+    g_ObjectsProgram              = objectsShader.ID;
+    g_ObjectUniforms.model        = objectsShader.uniform<glm::mat4>("model"); // Variável da matriz "model"
+    g_ObjectUniforms.object_id    = objectsShader.uniform<int>("object_id"); // Variável "object_id" em shader_fragment.glsl
+    g_ObjectUniforms.need_texture = objectsShader.uniform<int>("need_texture");
+    g_ObjectUniforms.instanced    = objectsShader.uniform<int>("instanced"); // Variável "instanced" em shader_vertex.glsl
+    g_ObjectUniforms.bbox_min     = objectsShader.uniform<glm::vec4>("bbox_min");
+    g_ObjectUniforms.bbox_max     = objectsShader.uniform<glm::vec4>("bbox_max");
+    g_ObjectUniforms.material_base = objectsShader.uniform<int>("material_base"); // Veja SceneObject::material_base
 
     // Variáveis em "shader_fragment.glsl" para acesso das imagens de textura
     objectsShader.use();
     objectsShader.setInt("TextureImage0", 0);
     objectsShader.setInt("TextureImage1", 1);
-    objectsShader.setInt("TextureImage2", 2);
     glUseProgram(0);
 
-//    // Carregamos duas imagens para serem utilizadas como textura
-    LoadTextureImage("../../data/texture/basalt.jpg");      // TextureImage0
-    LoadTextureImage("../../data/texture/steel.jpg");       // TextureImage1
-
-    // Construímos a representação de objetos geométricos através de malhas de triângulos
-    ObjModel spheremodel("../../data/SpaceShip.obj", "../../data/");
-    ComputeNormals(&spheremodel);
-    BuildTrianglesAndAddToVirtualScene(&spheremodel);
-    ObjModel bulletModel("../../data/bullet.obj", "../../data/");
-    ComputeNormals(&bulletModel);
-    BuildTrianglesAndAddToVirtualScene(&bulletModel);
-    ObjModel asteroidModel("../../data/asteroid.obj", "../../data/");
-    ComputeNormals(&asteroidModel);
-    BuildTrianglesAndAddToVirtualScene(&asteroidModel);
-
-    if ( argc > 1 )
-    {
-        ObjModel model(argv[1]);
-        BuildTrianglesAndAddToVirtualScene(&model);
-    }
-
-    // Inicializamos o código para renderização de texto.
-    TextRendering_Init();
-
     // Habilitamos o Z-buffer. Veja slide 108 do documento "Aula_09_Projecoes.pdf".
     glEnable(GL_DEPTH_TEST);
 
@@ -306,6 +604,9 @@ int main(int argc, char* argv[])
     float nearplane = -0.1f;  // Posição do "near plane"
     float farplane  = -40.0f; // Posição do "far plane"
 
+    // Fila de desenhos dos objetos opacos; a profundidade na chave vai até o far plane
+    RenderQueue render_queue(-farplane);
+
     //// SKY BOX INIT
     Shader skyboxShader("../../src/shaders/skybox.vs", "../../src/shaders/skybox.fs");
     float skyboxVertices[] = {
@@ -361,20 +662,77 @@ int main(int argc, char* argv[])
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    // Carrega as imagens do Cube map
-    std::vector<std::string> faces = {
-        "../../data/cubesmaps/simple/right.jpg",
-        "../../data/cubesmaps/simple/left.jpg",
-        "../../data/cubesmaps/simple/top.jpg",
-        "../../data/cubesmaps/simple/bottom.jpg",
-        "../../data/cubesmaps/simple/front.jpg",
-        "../../data/cubesmaps/simple/back.jpg"
-    };
-    unsigned int cubemapTexture = loadCubemap(faces);
     skyboxShader.use();
     skyboxShader.setInt("skybox", 0);
 
-    asteroids.push_back(generateNewAsteroid());
+    // As matrizes "view" e "projection" (e a posição da câmera e a direção
+    // da luz) ficam em um uniform buffer compartilhado pelos dois
+    // programas, enviado uma vez por quadro
+    FrameUniforms frame_uniforms;
+    frame_uniforms.attach(objectsShader.ID);
+    frame_uniforms.attach(skyboxShader.ID);
+    FrameUniformData frame;
+    frame.light_direction = glm::normalize(glm::vec4(1.0f, 1.0f, 0.0f, 0.0f));
+
+    // O mundo já existe durante o carregamento, porque KeyCallback() escreve
+    // em g_World->input; a malha de colisão da nave só chega no fim
+    GameWorld world(seed, threads);
+    world.maxAsteroids = max_asteroids;
+    g_World = &world;
+
+    // Tela de carregamento, até que todos os assets estejam na GPU
+    while (!assets.done() && !glfwWindowShouldClose(window))
+    {
+        assets.update(ASSET_UPLOAD_BUDGET);
+
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        TextRendering_ShowLoadingProgress(window, assets.loaded(), assets.total());
+
+        stream_buffer.endFrame();
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+    if (!assets.done())
+    {
+        // A janela foi fechada antes do fim do carregamento
+        glfwTerminate();
+        return 0;
+    }
+    printf("Assets carregados em %.0f ms.\n", (glfwGetTime() - load_start) * 1000.0);
+
+    const MeshId spaceship_base_mesh  = FindVirtualObject("Cube_Cube_Base");
+    const MeshId spaceship_black_mesh = FindVirtualObject("Cube_Cube_Black");
+    const MeshId bullet_mesh          = FindVirtualObject("bullet");
+    const MeshId asteroid_mesh        = FindVirtualObject("asteroid1");
+
+    UploadMaterials(objectsShader);
+
+    // Asteroides e tiros são desenhados com instancing
+    for (size_t lod = 0; lod < g_VirtualScene[asteroid_mesh].lods.size(); lod++)
+        AttachInstanceAttributes(g_VirtualScene[asteroid_mesh].lods[lod].vertex_array_object_id);
+    AttachInstanceAttributes(g_VirtualScene[bullet_mesh].vertex_array_object_id);
+    std::vector<glm::mat4> instance_models;
+    std::vector<glm::mat4> lod_models[MAX_LODS];
+
+    // Nível de detalhe atual de cada asteroide, indexado pelo slot do
+    // EntityHandle (estável entre quadros). Um slot reaproveitado herda o
+    // nível do asteroide anterior, o que só atrasa a primeira troca.
+    std::vector<uint8_t> asteroid_lods;
+
+    // Esferas envolventes (centro e raio) testadas contra o volume de visão
+    // antes de montar as instâncias; os asteroides usam direto os vetores
+    // do AsteroidField
+    std::vector<float> cull_x, cull_y, cull_z, cull_radius;
+    std::vector<uint8_t> visible;
+    const float bullet_scale = 0.1f;
+
+    world.setSpaceshipMesh(spaceship_triangles);
+
+    // Acumulador do tempo real ainda não simulado
+    float accumulator = 0.0f;
+    lastFrame = glfwGetTime();
 
     // Ficamos em loop, renderizando, até que o usuário feche a janela
     while (!glfwWindowShouldClose(window))
@@ -383,16 +741,25 @@ int main(int argc, char* argv[])
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        // Avançamos a simulação em passos fixos, independente do fps. O
+        // limite evita que uma pausa longa gere uma avalanche de ticks.
+        accumulator += std::min(deltaTime, 0.25f);
+        while (accumulator >= SIMULATION_TIMESTEP)
+        {
+            world.step(SIMULATION_TIMESTEP);
+            accumulator -= SIMULATION_TIMESTEP;
+        }
+        if (world.isGameOver())
+            gameOver();
+
+        Spaceship& spaceship = world.spaceship;
+
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 
         // "Pintamos" todos os pixels do framebuffer com a cor definida acima,
         // e também resetamos todos os pixels do Z-buffer (depth buffer).
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Pedimos para a GPU utilizar o programa de GPU criado acima (contendo
-        // os shaders de vértice e fragmentos).
-        objectsShader.use();
-
         // Computamos a posição da câmera utilizando coordenadas esféricas.  As
         // variáveis g_CameraDistance, g_CameraPhi, e g_CameraTheta são
         // controladas pelo mouse do usuário. Veja as funções CursorPosCallback()
@@ -433,126 +800,128 @@ int main(int argc, char* argv[])
         float field_of_view = 3.141592 / 3.0f;
         projection = Matrix_Perspective(field_of_view, g_ScreenRatio, nearplane, farplane);
 
-        // Actions
-        if (leftKeyPressed)
-            spaceship.bendLeft(deltaTime);
-        if (rightKeyPressed)
-            spaceship.bendRight(deltaTime);
-        if (topKeyPressed)
-            spaceship.speedUp(deltaTime);
-        if (downKeyPressed)
-            spaceship.brake(deltaTime);
-        if (spacePressed){
-            std::cout << "Shoot!" << std::endl;
-            bullets.push_back(spaceship.shoot());
-            spacePressed = false;
-        }
-
-        glm::mat4 model = Matrix_Identity();
-        glUniformMatrix4fv(view_uniform       , 1 , GL_FALSE , glm::value_ptr(view));
-        glUniformMatrix4fv(projection_uniform , 1 , GL_FALSE , glm::value_ptr(projection));
+        frame.view            = view;
+        frame.projection      = projection;
+        frame.view_projection = projection * view;
+        frame.camera_position = camera_position_c;
+        frame_uniforms.update(frame);
 
-        // asteroids logic
-        float random_float = static_cast <float> (rand()) / static_cast <float> (RAND_MAX * deltaTime);
-        if (asteroids.size() < MAX_ASTEROIDS) {
-            asteroids.push_back(generateNewAsteroid());
+        /////////////////////////////
+        // Enviamos o estado atual da simulação para a fila de desenho: uma
+        // chamada para todos os tiros, outra para todos os asteroides e uma
+        // para cada parte da nave. A fila decide a ordem. Tiros e
+        // asteroides fora do volume de visão (atrás da câmera, além do far
+        // plane ou dos lados) nem viram instâncias.
+        glm::vec3 camera_position = glm::vec3(camera_position_c);
+        Frustum frustum(frame.view_projection);
+        size_t num_visible = 0;
+
+        const BulletPool& bullets = world.bullets;
+        cull_x.resize(bullets.size());
+        cull_y.resize(bullets.size());
+        cull_z.resize(bullets.size());
+        cull_radius.assign(bullets.size(), bullet_scale);
+        visible.resize(bullets.size());
+        for (size_t i = 0; i < bullets.size(); i++) {
+            glm::vec4 position = bullets.position(i, world.time);
+            cull_x[i] = position.x;
+            cull_y[i] = position.y;
+            cull_z[i] = position.z;
         }
-
-        // remove asteroid very far
-        auto it = asteroids.begin();
-        while (it != asteroids.end()) {
-            Asteroid asteroid = *it;
-            glm::vec4 vecRelative = asteroid.position - spaceship.position;
-            if (norm(vecRelative) >= ASTEROIDS_DESTROY_DISTANCE) {
-                it = asteroids.erase(it);
-            } else {
-                it++;
-            }
+        num_visible += frustum.cullSpheres(cull_x.data(), cull_y.data(), cull_z.data(), cull_radius.data(),
+                                           g_VirtualScene[bullet_mesh].bounding_radius, bullets.size(), visible.data());
+
+        // A profundidade de um grupo de instâncias é a da mais próxima
+        float nearest = -farplane;
+        instance_models.clear();
+        for (size_t i = 0; i < bullets.size(); i++) {
+            if (!visible[i])
+                continue;
+            glm::vec3 position(cull_x[i], cull_y[i], cull_z[i]);
+            nearest = std::min(nearest, glm::length(position - camera_position));
+            instance_models.push_back(Matrix_Translate(glm::vec4(position, 1.0f))
+                                    * Matrix_Scale(bullet_scale, bullet_scale, bullet_scale));
         }
-        // remove bullet very far
-        auto it2 = bullets.begin();
-        while (it2 != bullets.end()) {
-            bullet _bullet = *it2;
-            glm::vec4 vecRelative = _bullet.current_position - spaceship.position;
-            if (norm(vecRelative) >= ASTEROIDS_DESTROY_DISTANCE) {
-                it2 = bullets.erase(it2);
-            } else {
-                it2++;
-            }
+        if (!instance_models.empty()) {
+            UploadInstances(g_VirtualScene[bullet_mesh].vertex_array_object_id, instance_models);
+            DrawItem item = VirtualObjectDrawItem(bullet_mesh, BULLET);
+            item.instances = instance_models.size();
+            item.depth = nearest;
+            render_queue.submit(item);
         }
 
-        /////////////////////////////
-        // New objects new positions
-        for (int i = 0; i < bullets.size(); i++) {
-            bullets[i].computeNewPosition(deltaTime);
-            model = Matrix_Translate(bullets[i].current_position)
-                  * Matrix_Scale(0.1f, 0.1f, 0.1f);
-            glUniformMatrix4fv(model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-            glUniform1i(object_id_uniform, BULLET);
-            DrawVirtualObject("bullet");
+        const AsteroidField& asteroids = world.asteroids;
+        const SceneObject& asteroid_object = g_VirtualScene[asteroid_mesh];
+        const float asteroid_radius = asteroid_object.bounding_radius;
+        visible.resize(asteroids.size());
+        num_visible += frustum.cullSpheres(asteroids.px.data(), asteroids.py.data(), asteroids.pz.data(), asteroids.scale.data(),
+                                           asteroid_radius, asteroids.size(), visible.data());
+
+        // Cada asteroide visível vai para o grupo de instâncias do seu nível
+        // de detalhe, escolhido pela fração da tela que ele ocupa
+        const float screen_scale = 1.0f / tanf(field_of_view / 2.0f);
+        float lod_nearest[MAX_LODS];
+        for (int lod = 0; lod < MAX_LODS; lod++) {
+            lod_models[lod].clear();
+            lod_nearest[lod] = -farplane;
         }
-
-        for (int i = 0; i < asteroids.size(); i++) {
-            asteroids[i].computeNewPosition(deltaTime);
-            model = Matrix_Translate(asteroids[i].position)
-                  * Matrix_Rotate_Z((float)glfwGetTime() * asteroids[i].rotation.z)
-                  * Matrix_Rotate_X((float)glfwGetTime() * asteroids[i].rotation.x)
-                  * Matrix_Rotate_Y((float)glfwGetTime() * asteroids[i].rotation.y)
-                  * Matrix_Scale(asteroids[i].scale, asteroids[i].scale, asteroids[i].scale);
-            glUniformMatrix4fv(model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-            glUniform1i(object_id_uniform, ASTEROID);
-            DrawVirtualObject("asteroid1");
+        for (size_t i = 0; i < asteroids.size(); i++) {
+            if (!visible[i])
+                continue;
+            float scale = asteroids.scale[i];
+            glm::vec4 position = asteroids.position(i);
+            float distance = glm::length(glm::vec3(position) - camera_position);
+
+            uint32_t slot = asteroids.handleAt(i).index;
+            if (slot >= asteroid_lods.size())
+                asteroid_lods.resize(slot + 1, 0);
+            float screen_size = scale * asteroid_radius * screen_scale / std::max(distance, -nearplane);
+            int lod = SelectLevelOfDetail(screen_size, asteroid_lods[slot], asteroid_object.lods.size());
+            asteroid_lods[slot] = lod;
+
+            lod_nearest[lod] = std::min(lod_nearest[lod], distance - scale * asteroid_radius);
+            lod_models[lod].push_back(Matrix_Translate(position)
+                                    * Matrix_Rotate_Z(world.time * asteroids.rz[i])
+                                    * Matrix_Rotate_X(world.time * asteroids.rx[i])
+                                    * Matrix_Rotate_Y(world.time * asteroids.ry[i])
+                                    * Matrix_Scale(scale, scale, scale));
         }
-
-        // Desenhamos o modelo da nave
-        glm::vec4 new_position = spaceship.computeNewPosition(deltaTime);
-        model = Matrix_Translate(new_position.x, new_position.y, new_position.z)
-//              * Matrix_Rotate_Z(0.0f)
-              * Matrix_Rotate_X(spaceship.phi)
-              * Matrix_Rotate_Y(spaceship.theta)
-              * Matrix_Scale(spaceship.scale, spaceship.scale, spaceship.scale);
-        glUniformMatrix4fv(model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(object_id_uniform, SPACESHIP);
-        glUniform1i(need_texture_uniform, 1);
-        DrawVirtualObject("Cube_Cube_Base");
-        glUniform1i(need_texture_uniform, 0);
-        DrawVirtualObject("Cube_Cube_Black");
-
-        ////////////////////////
-        // Test interception
-        for (int i = 0; i < asteroids.size(); i++) {
-            if (testInterseption(asteroids[i], spaceship, model)) {
-                asteroids.erase(asteroids.begin() + i);
-                spaceship.life--;
-                if (spaceship.life <= 0) {
-                    gameOver();
-                }
-            }
-
-            for (int j = i+1; j < asteroids.size(); j++) {
-                if (testInterseption(asteroids[i], asteroids[j])) {
-                    asteroids.erase(asteroids.begin() + i);
-                }
-            }
-
-            for (int j = 0; j < bullets.size(); j++) {
-                if (testInterseption(asteroids[i], bullets[j])) {
-                    player.score += 100;
-                    asteroids.erase(asteroids.begin() + i);
-                }
-            }
+        for (size_t lod = 0; lod < asteroid_object.lods.size(); lod++) {
+            if (lod_models[lod].empty())
+                continue;
+            UploadInstances(asteroid_object.lods[lod].vertex_array_object_id, lod_models[lod]);
+            DrawItem item = VirtualObjectDrawItem(asteroid_mesh, ASTEROID, lod);
+            item.instances = lod_models[lod].size();
+            item.depth = lod_nearest[lod];
+            render_queue.submit(item);
         }
+        size_t num_culled = bullets.size() + asteroids.size() - num_visible;
+
+        // O modelo da nave
+        float spaceship_depth = glm::length(glm::vec3(spaceship.position) - camera_position);
+        DrawItem spaceship_base = VirtualObjectDrawItem(spaceship_base_mesh, SPACESHIP);
+        spaceship_base.need_texture = 1;
+        spaceship_base.model = world.spaceshipModel;
+        spaceship_base.depth = spaceship_depth;
+        render_queue.submit(spaceship_base);
+        DrawItem spaceship_black = VirtualObjectDrawItem(spaceship_black_mesh, SPACESHIP);
+        spaceship_black.model = world.spaceshipModel;
+        spaceship_black.depth = spaceship_depth;
+        render_queue.submit(spaceship_black);
+
+        render_queue.flush();
 
         // Print game information
         TextRendering_ShowFramesPerSecond(window);
         TextRendering_ShowSpaceshipLife(window);
         TextRendering_ShowPlayerInfo(window);
+        TextRendering_ShowRenderStats(window, render_queue.stats);
+        TextRendering_ShowCullStats(window, num_visible, num_culled);
+        TextRendering_ShowStreamStats(window, stream_buffer.lastFrame);
 
         // draw skybox as last
         glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
         skyboxShader.use();
-        skyboxShader.setMat4("view", glm::mat4(glm::mat3(view)));
-        skyboxShader.setMat4("projection", projection);
         // skybox cube
         glBindVertexArray(skyboxVAO);
         glActiveTexture(GL_TEXTURE0);
@@ -561,6 +930,8 @@ int main(int argc, char* argv[])
         glBindVertexArray(0);
         glDepthFunc(GL_LESS); // set depth function back to default
 
+        stream_buffer.endFrame();
+
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
@@ -574,17 +945,13 @@ int main(int argc, char* argv[])
 }
 
 
-// Função que carrega uma imagem para ser utilizada como textura
-void LoadTextureImage(const char* filename)
+// Lê uma imagem RGB do disco para a memória, com a linha de baixo primeiro
+// (como o OpenGL espera; veja stbi_set_flip_vertically_on_load() em main()).
+// Pode ser chamada de qualquer thread.
+void LoadImageRGB(const char* filename, ImageRGB* image)
 {
-    printf("Carregando imagem \"%s\"... ", filename);
-
-    // Primeiro fazemos a leitura da imagem do disco
-    stbi_set_flip_vertically_on_load(true);
-    int width;
-    int height;
     int channels;
-    unsigned char *data = stbi_load(filename, &width, &height, &channels, 3);
+    unsigned char *data = stbi_load(filename, &image->width, &image->height, &channels, 3);
 
     if ( data == NULL )
     {
@@ -592,9 +959,121 @@ void LoadTextureImage(const char* filename)
         std::exit(EXIT_FAILURE);
     }
 
-    printf("OK (%dx%d).\n", width, height);
+    printf("Carregando imagem \"%s\"... OK (%dx%d).\n", filename, image->width, image->height);
 
-    // Agora criamos objetos na GPU com OpenGL para armazenar a textura
+    image->texels.assign(data, data + 3 * image->width * image->height);
+    stbi_image_free(data);
+}
+
+// Amostra a imagem em (u,v) como texture() faria no nível 0 de uma textura
+// GL_SRGB8 com GL_LINEAR e GL_CLAMP_TO_EDGE: os texels são convertidos de
+// sRGB para linear e interpolados bilinearmente.
+glm::vec3 SampleImageBilinear(const ImageRGB& image, glm::vec2 uv)
+{
+    // Inicializada uma única vez mesmo com várias threads carregando
+    // modelos (estáticas locais são thread-safe em C++11)
+    struct SrgbTable
+    {
+        float to_linear[256];
+        SrgbTable()
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                float c = i / 255.0f;
+                to_linear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+        }
+    };
+    static const SrgbTable srgb;
+    const float* srgb_to_linear = srgb.to_linear;
+
+    float x = uv.x * image.width - 0.5f;
+    float y = uv.y * image.height - 0.5f;
+    int x0 = (int)std::floor(x);
+    int y0 = (int)std::floor(y);
+    float fx = x - x0;
+    float fy = y - y0;
+
+    glm::vec3 texel[2][2];
+    for (int j = 0; j < 2; j++)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            int tx = std::min(std::max(x0 + i, 0), image.width - 1);
+            int ty = std::min(std::max(y0 + j, 0), image.height - 1);
+            const unsigned char* rgb = &image.texels[3 * (ty * image.width + tx)];
+            texel[j][i] = glm::vec3(srgb_to_linear[rgb[0]], srgb_to_linear[rgb[1]], srgb_to_linear[rgb[2]]);
+        }
+    }
+
+    glm::vec3 bottom = texel[0][0] * (1.0f - fx) + texel[0][1] * fx;
+    glm::vec3 top    = texel[1][0] * (1.0f - fx) + texel[1][1] * fx;
+    return bottom * (1.0f - fy) + top * fy;
+}
+
+// Cores de vértice são guardadas com gamma 2.2, para não perder os tons
+// escuros em 8 bits; "shader_vertex.glsl" desfaz com pow(cor, 2.2)
+uint8_t LinearToGamma8(float value)
+{
+    value = glm::clamp(value, 0.0f, 1.0f);
+    return (uint8_t)(std::pow(value, 1.0f / 2.2f) * 255.0f + 0.5f);
+}
+
+// Projeção esférica em torno de "center": U é o ângulo em torno do eixo Y
+// e V a latitude, ambos levados para [0,1]
+glm::vec2 SphericalMapping(const glm::vec3& center, const glm::vec3& position)
+{
+    glm::vec3 p_vector = glm::normalize(position - center);
+    float phi = std::asin(glm::clamp(p_vector.y, -1.0f, 1.0f));
+    float theta = std::atan2(p_vector.x, p_vector.z);
+
+    const float pi = 3.14159265358979323846f;
+    float U = (theta + pi) / (2*pi);
+    float V = (phi + pi/2) / pi;
+    return glm::vec2(U, V);
+}
+
+// Os materiais são constantes de um programa: são enviados uma vez, depois
+// de carregados todos os modelos, em três arrays de vec4 indexados pelo
+// material de cada vértice (PackedVertex::material)
+void UploadMaterials(Shader& shader)
+{
+    std::vector<glm::vec4> Kd, Ks, Ka;
+    for (size_t i = 0; i < g_Materials.size(); ++i)
+    {
+        Kd.push_back(g_Materials[i].Kd);
+        Ks.push_back(g_Materials[i].Ks);
+        Ka.push_back(g_Materials[i].Ka);
+    }
+
+    shader.use();
+    shader.setVec4Array("materials_Kd", Kd.data(), Kd.size());
+    shader.setVec4Array("materials_Ks", Ks.data(), Ks.size());
+    shader.setVec4Array("materials_Ka", Ka.data(), Ka.size());
+    glUseProgram(0);
+}
+
+// Função que carrega uma imagem para ser utilizada como textura. A leitura
+// do disco, a geração dos mipmaps e a compressão são feitas em segundo
+// plano (veja LoadCookedTexture()); a unidade de textura é reservada já
+// aqui, então as texturas ficam nas unidades na ordem das chamadas.
+void LoadTextureImage(AssetQueue& assets, const char* filename, bool use_cache)
+{
+    std::vector<std::string> filenames(1, filename);
+    int format = g_TextureFormat;
+    GLuint textureunit = g_NumLoadedTextures++;
+    assets.load([filenames, format, use_cache, textureunit](std::vector<AssetQueue::Upload>& uploads) {
+        std::shared_ptr<CookedTexture> texture = std::make_shared<CookedTexture>();
+        LoadCookedTexture(filenames, format, use_cache, texture.get());
+        uploads.push_back([texture, textureunit] { UploadTextureImage(*texture, textureunit); });
+    });
+}
+
+// Envia uma textura preparada por LoadCookedTexture() para a GPU, na
+// unidade "textureunit"
+void UploadTextureImage(const CookedTexture& texture, GLuint textureunit)
+{
+    // Criamos objetos na GPU com OpenGL para armazenar a textura
     GLuint texture_id;
     GLuint sampler_id;
     glGenTextures(1, &texture_id);
@@ -608,55 +1087,362 @@ void LoadTextureImage(const char* filename)
     glSamplerParameteri(sampler_id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glSamplerParameteri(sampler_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // Agora enviamos a imagem lida do disco para a GPU
+    // Agora enviamos a imagem, já com todos os níveis de mipmap, para a GPU
+    glActiveTexture(GL_TEXTURE0 + textureunit);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.info[3] - 1);
+    UploadCookedImage(GL_TEXTURE_2D, texture, 0, true);
+    glBindSampler(textureunit, sampler_id);
+}
+
+// Escolhe o formato das texturas: "requested" ("rgb", "bc1" ou "bc7"), se
+// a GPU aceitar, senão o mais compacto que ela aceita. BC1 precisa de S3TC
+// com sRGB; BC7 (BPTC) é do núcleo desde o OpenGL 4.2.
+int SelectTextureFormat(const std::string& requested)
+{
+    bool s3tc = false, s3tc_srgb = false, bptc = false;
+
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bptc = major > 4 || (major == 4 && minor >= 2);
+
+    GLint num_extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+    for (GLint i = 0; i < num_extensions; i++)
+    {
+        std::string extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension == "GL_EXT_texture_compression_s3tc")
+            s3tc = true;
+        else if (extension == "GL_EXT_texture_sRGB" || extension == "GL_EXT_texture_compression_s3tc_srgb")
+            s3tc_srgb = true;
+        else if (extension == "GL_ARB_texture_compression_bptc")
+            bptc = true;
+    }
+    bool bc1 = s3tc && s3tc_srgb;
+
+    int format = bptc ? TEXTURE_BC7 : bc1 ? TEXTURE_BC1 : TEXTURE_RGB8;
+    if (requested == "rgb")
+        format = TEXTURE_RGB8;
+    else if (requested == "bc1" && bc1)
+        format = TEXTURE_BC1;
+    else if (requested == "bc7" && bptc)
+        format = TEXTURE_BC7;
+    else if (!requested.empty())
+        fprintf(stderr, "WARNING: texture format \"%s\" not supported.\n", requested.c_str());
+
+    const char* names[] = { "RGB8", "BC1", "BC7" };
+    printf("Formato das texturas: %s\n", names[format]);
+    return format;
+}
+
+// Prepara as imagens "filenames" (uma, ou as seis faces de um cube map) no
+// formato "format", com todos os níveis de mipmap (veja cookTexture()). As
+// imagens são decodificadas e comprimidas em paralelo; com "use_cache", o
+// resultado é gravado em "<primeira imagem>.texture.cache" e, nas execuções
+// seguintes, enquanto as imagens e o formato não mudarem, os níveis vêm
+// direto do arquivo mapeado na memória, sem decodificar PNG/JPEG nem
+// comprimir nada.
+void LoadCookedTexture(const std::vector<std::string>& filenames, int format, bool use_cache, CookedTexture* texture)
+{
+    int count = (int)filenames.size();
+    std::string cache_filename = filenames[0] + ".texture.cache";
+    uint32_t version = (TEXTURE_CACHE_VERSION << 8) | format;
+
+    bool cached = false;
+    if (use_cache && texture->cache.open(cache_filename.c_str(), filenames, version))
+    {
+        size_t bytes = 0;
+        const void* info = texture->cache.chunk(TEXTURE_CHUNK_INFO, &bytes);
+        cached = info != NULL && bytes == sizeof(texture->info);
+        if (cached)
+        {
+            memcpy(texture->info, info, sizeof(texture->info));
+
+            // Tamanho esperado de cada imagem, com todos os níveis
+            size_t image_bytes = 0;
+            for (int level = 0, w = texture->info[1], h = texture->info[2]; level < texture->info[3]; level++)
+            {
+                image_bytes += textureLevelBytes(format, w, h);
+                w = std::max(1, w / 2);
+                h = std::max(1, h / 2);
+            }
+            for (int i = 0; i < count && cached; i++)
+            {
+                texture->images[i] = (const unsigned char*)texture->cache.chunk(TEXTURE_CHUNK_IMAGE(i), &bytes);
+                cached = texture->images[i] != NULL && bytes == image_bytes;
+            }
+        }
+        if (cached)
+            printf("Carregando textura \"%s\" do cache... OK.\n", filenames[0].c_str());
+        else
+            texture->cache.close();
+    }
+    if (cached)
+        return;
+
+    ImageRGB images[6];
+    int levels[6];
+    g_LoaderJobs->parallelFor(0, count, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            LoadImageRGB(filenames[i].c_str(), &images[i]);
+            levels[i] = cookTexture(images[i].texels.data(), images[i].width, images[i].height, format,
+                                    &texture->cooked[i], *g_LoaderJobs);
+            texture->images[i] = texture->cooked[i].data();
+        }
+    });
+
+    for (int i = 1; i < count; i++)
+    {
+        if (images[i].width != images[0].width || images[i].height != images[0].height)
+        {
+            fprintf(stderr, "ERROR: Images of texture \"%s\" differ in size.\n", filenames[0].c_str());
+            std::exit(EXIT_FAILURE);
+        }
+    }
+    texture->info[0] = format;
+    texture->info[1] = images[0].width;
+    texture->info[2] = images[0].height;
+    texture->info[3] = levels[0];
+
+    if (use_cache)
+    {
+        MeshCacheWriter writer;
+        writer.add(TEXTURE_CHUNK_INFO, texture->info, sizeof(texture->info));
+        for (int i = 0; i < count; i++)
+            writer.addArray(TEXTURE_CHUNK_IMAGE(i), texture->cooked[i]);
+        if (!writer.write(cache_filename.c_str(), filenames, version))
+            fprintf(stderr, "WARNING: cannot write texture cache \"%s\".\n", cache_filename.c_str());
+    }
+}
+
+// Envia todos os níveis da imagem "image" de "texture" para "target" (a
+// textura já ligada, ou uma face dela). Formatos comprimidos vão direto com
+// glCompressedTexImage2D(), sem gerar mipmaps na GPU.
+void UploadCookedImage(GLenum target, const CookedTexture& texture, int image, bool srgb)
+{
+    int format = texture.info[0];
+    GLenum internal_format;
+    if (format == TEXTURE_BC1)
+        internal_format = srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    else if (format == TEXTURE_BC7)
+        internal_format = srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+    else
+        internal_format = srgb ? GL_SRGB8 : GL_RGB8;
+
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
     glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
 
-    GLuint textureunit = g_NumLoadedTextures;
-    glActiveTexture(GL_TEXTURE0 + textureunit);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glBindSampler(textureunit, sampler_id);
+    const unsigned char* data = texture.images[image];
+    int w = texture.info[1];
+    int h = texture.info[2];
+    for (int level = 0; level < texture.info[3]; level++)
+    {
+        size_t bytes = textureLevelBytes(format, w, h);
+        if (format == TEXTURE_RGB8)
+            glTexImage2D(target, level, internal_format, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+        else
+            glCompressedTexImage2D(target, level, internal_format, w, h, 0, (GLsizei)bytes, data);
+        data += bytes;
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+}
 
-    stbi_image_free(data);
+// Monta o desenho de um objeto armazenado em g_VirtualScene, para ser
+// enviado à RenderQueue. Veja definição dos objetos na função
+// AddMeshToVirtualScene(). O chamador ajusta "model",
+// "need_texture", "instances" e "depth" conforme o caso. "lod" escolhe o
+// nível de detalhe (veja GenerateLevelsOfDetail()).
+DrawItem VirtualObjectDrawItem(MeshId mesh, int object_id, int lod)
+{
+    const SceneObject& object = g_VirtualScene[mesh];
+    const LevelOfDetail& level = object.lods[lod];
+
+    DrawItem item;
+    item.program                = g_ObjectsProgram;
+    item.uniforms               = &g_ObjectUniforms;
+    item.vertex_array_object_id = level.vertex_array_object_id;
+    item.rendering_mode         = object.rendering_mode;
+    item.first_index            = level.first_index;
+    item.num_indices            = level.num_indices;
+    item.instances              = 0;
+    item.object_id              = object_id;
+    item.need_texture           = 0;
+    item.model                  = Matrix_Identity();
+    item.bbox_min               = object.bbox_min;
+    item.bbox_max               = object.bbox_max;
+    item.material_base          = object.material_base;
+    item.depth                  = 0.0f;
+    return item;
+}
+
+// Habilita os atributos "instance_model" (locations 7 a 10, uma coluna da
+// matriz em cada) de um VAO de objeto. Cada instância avança uma matriz
+// (divisor 1). Os dados ficam em g_StreamBuffer, em um lugar diferente a
+// cada quadro; veja UploadInstances().
+void AttachInstanceAttributes(GLuint vertex_array_object_id)
+{
+    glBindVertexArray(vertex_array_object_id);
+    glBindBuffer(GL_ARRAY_BUFFER, g_StreamBuffer->id());
+    for (GLuint column = 0; column < 4; column++)
+    {
+        GLuint location = 7 + column; // "(location = 7)" em "shader_vertex.glsl"
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
 
-    g_NumLoadedTextures += 1;
+// Envia uma matriz "model" por cópia do objeto para g_StreamBuffer e aponta
+// os atributos "instance_model" do VAO para elas. O VAO precisa ter passado
+// por AttachInstanceAttributes(); o desenho em si é um DrawItem com
+// "instances" igual a models.size(), no mesmo quadro.
+void UploadInstances(GLuint vertex_array_object_id, const std::vector<glm::mat4>& models)
+{
+    size_t offset = g_StreamBuffer->write(models.data(), models.size() * sizeof(glm::mat4));
+
+    glBindVertexArray(vertex_array_object_id);
+    glBindBuffer(GL_ARRAY_BUFFER, g_StreamBuffer->id());
+    for (GLuint column = 0; column < 4; column++)
+        glVertexAttribPointer(7 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(offset + column * sizeof(glm::vec4)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
 }
 
-// Função que desenha um objeto armazenado em g_VirtualScene. Veja definição
-// dos objetos na função BuildTrianglesAndAddToVirtualScene().
-void DrawVirtualObject(const char* object_name)
+// Gera os níveis de detalhe 1, 2, ... de cada objeto de um ObjModel já
+// processado por BuildMesh() (que preencheu "mesh" e "corner_vertices").
+// Cada nível é o anterior simplificado com simplifyMesh() até
+// 1/LOD_TRIANGLE_RATIO dos triângulos, sobre os vértices soldados pelo
+// índice do ".obj". Os índices dos níveis apontam para mesh->vertices: para
+// cada vértice soldado usamos o primeiro canto de triângulo que o
+// referencia, então normais e coordenadas de textura nas costuras vêm de um
+// dos lados. Todos os níveis ficam em mesh->lod_indices; veja
+// AddMeshToVirtualScene().
+void GenerateLevelsOfDetail(ObjModel* model, const std::vector<GLuint>& corner_vertices, MeshData* mesh)
 {
-    // "Ligamos" o VAO. Informamos que queremos utilizar os atributos de
-    // vértices apontados pelo VAO criado pela função BuildTrianglesAndAddToVirtualScene(). Veja
-    // comentários detalhados dentro da definição de BuildTrianglesAndAddToVirtualScene().
-    glBindVertexArray(g_VirtualScene[object_name].vertex_array_object_id);
-
-    // Setamos as variáveis "bbox_min" e "bbox_max" do fragment shader
-    // com os parâmetros da axis-aligned bounding box (AABB) do modelo.
-    glm::vec3 bbox_min = g_VirtualScene[object_name].bbox_min;
-    glm::vec3 bbox_max = g_VirtualScene[object_name].bbox_max;
-    glUniform4f(bbox_min_uniform, bbox_min.x, bbox_min.y, bbox_min.z, 1.0f);
-    glUniform4f(bbox_max_uniform, bbox_max.x, bbox_max.y, bbox_max.z, 1.0f);
-
-    // Pedimos para a GPU rasterizar os vértices dos eixos XYZ
-    // apontados pelo VAO como linhas. Veja a definição de
-    // g_VirtualScene[""] dentro da função BuildTrianglesAndAddToVirtualScene(), e veja
-    // a documentação da função glDrawElements() em
-    // http://docs.gl/gl3/glDrawElements.
-    glDrawElements(
-        g_VirtualScene[object_name].rendering_mode,
-        g_VirtualScene[object_name].num_indices,
-        GL_UNSIGNED_INT,
-        (void*)(g_VirtualScene[object_name].first_index * sizeof(GLuint))
-    );
+    size_t vertex_count = mesh->vertices.size();
 
-    // "Desligamos" o VAO, evitando assim que operações posteriores venham a
-    // alterar o mesmo. Isso evita bugs.
+    std::vector<glm::vec3> positions(model->attrib.vertices.size() / 3);
+    for (size_t i = 0; i < positions.size(); i++)
+        positions[i] = glm::vec3(model->attrib.vertices[3*i + 0], model->attrib.vertices[3*i + 1], model->attrib.vertices[3*i + 2]);
+
+    for (size_t shape = 0; shape < model->shapes.size(); ++shape)
+    {
+        const tinyobj::mesh_t& shape_mesh = model->shapes[shape].mesh;
+
+        // vértice soldado -> canto em mesh->vertices
+        std::vector<uint32_t> welded(shape_mesh.indices.size());
+        std::vector<GLuint> corner(positions.size(), std::numeric_limits<GLuint>::max());
+        for (size_t i = 0; i < shape_mesh.indices.size(); i++)
+        {
+            int v = shape_mesh.indices[i].vertex_index;
+            welded[i] = v;
+            if (corner[v] == std::numeric_limits<GLuint>::max())
+                corner[v] = corner_vertices[mesh->shapes[shape].first_index + i];
+        }
+
+        for (int lod = 1; lod < MAX_LODS; lod++)
+        {
+            size_t target = welded.size() / 3 / LOD_TRIANGLE_RATIO;
+            float error;
+            std::vector<uint32_t> simplified = simplifyMesh(positions, welded, target, &error);
+            if (simplified.size() == welded.size())
+                break; // não há mais o que simplificar
+
+            printf("LOD %d de \"%s\": %d triângulos (erro %g)\n", lod, model->shapes[shape].name.c_str(),
+                   (int)(simplified.size() / 3), error);
+
+            MeshLevel level;
+            level.shape       = shape;
+            level.first_index = mesh->lod_indices.size();
+            level.num_indices = simplified.size();
+            for (size_t i = 0; i < simplified.size(); i++)
+                mesh->lod_indices.push_back(corner[simplified[i]]);
+            optimizeVertexCache(&mesh->lod_indices[level.first_index], level.num_indices, vertex_count);
+            mesh->levels.push_back(level);
+            welded.swap(simplified);
+        }
+    }
+}
+
+// Cria um VAO com os mesmos atributos de vértice (buffers, formatos e
+// divisores) de "source", mas com "element_buffer" como buffer de índices
+GLuint CloneVertexArray(GLuint source, GLuint element_buffer)
+{
+    struct Attribute
+    {
+        GLint enabled, buffer, size, type, normalized, integer, stride, divisor;
+        void* pointer;
+    };
+
+    GLint max_attributes;
+    glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &max_attributes);
+    std::vector<Attribute> attributes(max_attributes);
+
+    glBindVertexArray(source);
+    for (GLint i = 0; i < max_attributes; i++)
+    {
+        Attribute& a = attributes[i];
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &a.enabled);
+        if (!a.enabled)
+            continue;
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &a.buffer);
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_SIZE, &a.size);
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_TYPE, &a.type);
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &a.normalized);
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_INTEGER, &a.integer);
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &a.stride);
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_DIVISOR, &a.divisor);
+        glGetVertexAttribPointerv(i, GL_VERTEX_ATTRIB_ARRAY_POINTER, &a.pointer);
+    }
+
+    GLuint vertex_array_object_id;
+    glGenVertexArrays(1, &vertex_array_object_id);
+    glBindVertexArray(vertex_array_object_id);
+    for (GLint i = 0; i < max_attributes; i++)
+    {
+        const Attribute& a = attributes[i];
+        if (!a.enabled)
+            continue;
+        glBindBuffer(GL_ARRAY_BUFFER, a.buffer);
+        if (a.integer)
+            glVertexAttribIPointer(i, a.size, a.type, a.stride, a.pointer);
+        else
+            glVertexAttribPointer(i, a.size, a.type, a.normalized, a.stride, a.pointer);
+        glVertexAttribDivisor(i, a.divisor);
+        glEnableVertexAttribArray(i);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer);
     glBindVertexArray(0);
+
+    return vertex_array_object_id;
+}
+
+// Nível de detalhe para um objeto que ocupa "screen_size" da metade da
+// altura da tela e que estava no nível "current". O nível atual é mantido
+// enquanto o tamanho estiver dentro da faixa dele alargada por
+// LOD_HYSTERESIS; fora dela, vale o nível da faixa onde o tamanho cai.
+int SelectLevelOfDetail(float screen_size, int current, int num_lods)
+{
+    if (current >= num_lods)
+        current = num_lods - 1;
+
+    float upper = current > 0 ? LOD_SCREEN_SIZE[current - 1] * (1.0f + LOD_HYSTERESIS) : std::numeric_limits<float>::max();
+    float lower = current < num_lods - 1 ? LOD_SCREEN_SIZE[current] * (1.0f - LOD_HYSTERESIS) : 0.0f;
+    if (screen_size >= lower && screen_size < upper)
+        return current;
+
+    int lod = 0;
+    while (lod < num_lods - 1 && screen_size < LOD_SCREEN_SIZE[lod])
+        lod++;
+    return lod;
 }
 
 // Função que computa as normais de um ObjModel, caso elas não tenham sido
@@ -722,79 +1508,72 @@ void ComputeNormals(ObjModel* model)
     }
 }
 
-// teste esfera-triangulo
-bool testInterseption(Asteroid asteroid, Spaceship spaceship, glm::mat4 model) {
-    // 1) teste esfera-esfera (barato)
-    float sphere_radius = (1/asteroid.scale) * 0.04;
-    float spaceship_radius = (1/spaceship.scale) * 0.35;
-    float distance = norm(asteroid.position - spaceship.position);
-    if ((sphere_radius + spaceship_radius) > distance) {
-        // 2) caso passar, testar se algum vertice do modelo da
-        //    nave está dentro da esfera. esfera-ponto (custoso)
-        std::vector<glm::vec4> vertices = g_VirtualScene["Cube_Cube_Base"].vertices;
-        for (int i = 0; i < g_VirtualScene["Cube_Cube_Black"].vertices.size(); i++) {
-            vertices.push_back(g_VirtualScene["Cube_Cube_Black"].vertices[i]);
-        }
-        for (int i = 0; i < vertices.size(); i++) {
-            // scale, rotate, ...
-            glm::vec4 vertice = matrixVectorProduct(model, vertices[i]);
-            float distance = norm(vertice - asteroid.position);
-            if (distance < sphere_radius) {
-                return true;
-            }
+// Coleta os vértices (espaço do modelo) de todos os triângulos de um
+// ObjModel, na ordem dos cantos de triângulo do ".obj".
+// Utilizada pelos testes de colisão com a nave.
+std::vector<glm::vec4> CollectModelVertices(ObjModel* model)
+{
+    std::vector<glm::vec4> vertices;
+    for (size_t shape = 0; shape < model->shapes.size(); ++shape)
+    {
+        const tinyobj::mesh_t& mesh = model->shapes[shape].mesh;
+        for (size_t i = 0; i < mesh.indices.size(); ++i)
+        {
+            int vertex_index = mesh.indices[i].vertex_index;
+            const float vx = model->attrib.vertices[3*vertex_index + 0];
+            const float vy = model->attrib.vertices[3*vertex_index + 1];
+            const float vz = model->attrib.vertices[3*vertex_index + 2];
+            vertices.push_back(glm::vec4(vx, vy, vz, 1.0f));
         }
     }
-    return false;
-}
-
-// teste esfera-esfera
-bool testInterseption(Asteroid asteroid1, Asteroid asteroid2) {
-    float C = 0.04;
-    float r1 = (1/asteroid1.scale) * C;
-    float r2 = (1/asteroid2.scale) * C;
-    float distance = norm(asteroid1.position - asteroid2.position);
-    return (r1 + r2) > distance;
+    return vertices;
 }
 
-// teste raio-esfera
-bool testInterseption(Asteroid asteroid, bullet b) {
-    float r = (1/asteroid.scale) * 0.04;
-    glm::vec4 c = b.start_position;
-    glm::vec4 s = asteroid.position;
-    glm::vec4 d = b.direction;
-    float A = std::pow(norm(d), 2);
-    float B = dotproduct(scalarproduct(d, 2.0f), (c - s));
-    float C = std::pow(norm(c - s), 2) - std::pow(r, 2);
-
-    float delta = std::pow(B, 2) - 4 * A * C;
-    if (delta >= 0) {
-        float t1 = (-B + std::sqrt(delta)) / (2*A);
-        float t2 = (-B - std::sqrt(delta)) / (2*A);
-        return b.t >= t1;
-    } else {
-        return false;
+// Busca o MeshId de um objeto pelo nome. Um nome inexistente é um erro de
+// programação: abortamos em vez de desenhar um objeto vazio.
+MeshId FindVirtualObject(const char* object_name)
+{
+    std::map<std::string, MeshId>::const_iterator it = g_VirtualSceneNames.find(object_name);
+    if (it == g_VirtualSceneNames.end())
+    {
+        fprintf(stderr, "ERROR: Virtual object \"%s\" not found.\n", object_name);
+        std::exit(EXIT_FAILURE);
     }
+    return it->second;
 }
 
-
-// Constrói triângulos para futura renderização a partir de um ObjModel.
-void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
+// Constrói triângulos para futura renderização a partir de um ObjModel,
+// sem OpenGL: o resultado vai para "mesh" e é enviado à GPU por
+// AddMeshToVirtualScene(). Cada "shape" do modelo vira uma MeshShape. Os
+// vértices ficam intercalados no formato PackedVertex; os materiais do
+// modelo vão para mesh->materials e cada vértice guarda o índice do seu.
+//
+// Cantos de triângulo iguais (posição, normal, coordenadas de textura, cor
+// e material) viram um só vértice, e os triângulos de cada shape são
+// reordenados para o cache pós-transformação e para reduzir overdraw;
+// veja "MeshOptimizer.h". As medidas antes e depois são impressas.
+//
+// Se "spherical_albedo" não for NULL, a cor de cada vértice é amostrada
+// dessa imagem com mapeamento esférico em torno do centro da bounding box
+// da shape. É o que o vertex shader dos asteroides fazia a cada quadro,
+// para cada vértice de cada instância; as coordenadas só dependem da
+// posição no modelo.
+//
+// "options" (MESH_LEVELS_OF_DETAIL, MESH_COLLISION) diz o que mais gerar.
+void BuildMesh(ObjModel* model, const ImageRGB* spherical_albedo, unsigned int options, MeshData* mesh)
 {
-    GLuint vertex_array_object_id;
-    glGenVertexArrays(1, &vertex_array_object_id);
-    glBindVertexArray(vertex_array_object_id);
-
-    std::vector<GLuint> indices;
-    std::vector<float>  model_coefficients;
-    std::vector<float>  normal_coefficients;
-    std::vector<float>  texture_coefficients;
-
-    std::vector<float>  material_diffuse_coefficients;
-    std::vector<float>  material_speculate_coefficients;
-    std::vector<float>  material_environment_coefficients;
-    std::vector<float>  material_specular_exponent_coefficients;
+    std::vector<GLuint>& indices = mesh->indices;
+    std::vector<PackedVertex> vertices;
 
-    std::vector<glm::vec4> vertices;
+    for (size_t material = 0; material < model->materials.size(); ++material)
+    {
+        const tinyobj::material_t& m = model->materials[material];
+        Material constants;
+        constants.Kd = glm::vec4(m.diffuse[0], m.diffuse[1], m.diffuse[2], 0.0f);
+        constants.Ks = glm::vec4(m.specular[0], m.specular[1], m.specular[2], m.shininess);
+        constants.Ka = glm::vec4(m.ambient[0], m.ambient[1], m.ambient[2], 0.0f);
+        mesh->materials.push_back(constants);
+    }
 
     for (size_t shape = 0; shape < model->shapes.size(); ++shape)
     {
@@ -807,6 +1586,11 @@ void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
         glm::vec3 bbox_min = glm::vec3(maxval,maxval,maxval);
         glm::vec3 bbox_max = glm::vec3(minval,minval,minval);
 
+        // Material da shape (0 = sem material)
+        uint8_t material = 0;
+        if (shape < mesh->materials.size() && shape < MAX_MATERIALS - 1)
+            material = (uint8_t)(shape + 1);
+
         for (size_t triangle = 0; triangle < num_triangles; ++triangle)
         {
             assert(model->shapes[shape].mesh.num_face_vertices[triangle] == 3);
@@ -818,15 +1602,15 @@ void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
 
                 indices.push_back(first_index + 3*triangle + vertex);
 
+                PackedVertex packed;
+
                 const float vx = model->attrib.vertices[3*idx.vertex_index + 0];
                 const float vy = model->attrib.vertices[3*idx.vertex_index + 1];
                 const float vz = model->attrib.vertices[3*idx.vertex_index + 2];
                 //printf("tri %d vert %d = (%.2f, %.2f, %.2f)\n", (int)triangle, (int)vertex, vx, vy, vz);
-                model_coefficients.push_back( vx ); // X
-                model_coefficients.push_back( vy ); // Y
-                model_coefficients.push_back( vz ); // Z
-                model_coefficients.push_back( 1.0f ); // W
-                vertices.push_back(glm::vec4(vx, vy, vz, 1.0f));
+                packed.position[0] = vx; // X
+                packed.position[1] = vy; // Y
+                packed.position[2] = vz; // Z
 
                 bbox_min.x = std::min(bbox_min.x, vx);
                 bbox_min.y = std::min(bbox_min.y, vy);
@@ -840,229 +1624,389 @@ void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
                 // existem normais e coordenadas de textura no ObjModel é
                 // comparando se o índice retornado é -1. Fazemos isso abaixo.
 
+                glm::vec3 n(0.0f, 0.0f, 0.0f);
                 if ( idx.normal_index != -1 )
                 {
-                    const float nx = model->attrib.normals[3*idx.normal_index + 0];
-                    const float ny = model->attrib.normals[3*idx.normal_index + 1];
-                    const float nz = model->attrib.normals[3*idx.normal_index + 2];
-                    normal_coefficients.push_back( nx ); // X
-                    normal_coefficients.push_back( ny ); // Y
-                    normal_coefficients.push_back( nz ); // Z
-                    normal_coefficients.push_back( 0.0f ); // W
+                    n.x = model->attrib.normals[3*idx.normal_index + 0];
+                    n.y = model->attrib.normals[3*idx.normal_index + 1];
+                    n.z = model->attrib.normals[3*idx.normal_index + 2];
+                    float length = glm::length(n);
+                    if (length > 0.0f)
+                        n /= length;
                 }
+                packed.normal = glm::packSnorm3x10_1x2(glm::vec4(n, 0.0f));
 
+                glm::vec2 uv(0.0f, 0.0f);
                 if ( idx.texcoord_index != -1 )
                 {
-                    const float u = model->attrib.texcoords[2*idx.texcoord_index + 0];
-                    const float v = model->attrib.texcoords[2*idx.texcoord_index + 1];
-                    texture_coefficients.push_back( u );
-                    texture_coefficients.push_back( v );
-                }
-                if (shape < model->materials.size()) {
-                    // diffuse
-                    material_diffuse_coefficients.push_back(model->materials[shape].diffuse[0]);
-                    material_diffuse_coefficients.push_back(model->materials[shape].diffuse[1]);
-                    material_diffuse_coefficients.push_back(model->materials[shape].diffuse[2]);
-                    // specular
-                    material_speculate_coefficients.push_back(model->materials[shape].specular[0]);
-                    material_speculate_coefficients.push_back(model->materials[shape].specular[1]);
-                    material_speculate_coefficients.push_back(model->materials[shape].specular[2]);
-                    // ambient
-                    material_environment_coefficients.push_back(model->materials[shape].ambient[0]);
-                    material_environment_coefficients.push_back(model->materials[shape].ambient[1]);
-                    material_environment_coefficients.push_back(model->materials[shape].ambient[2]);
-                    // specular
-                    material_specular_exponent_coefficients.push_back(model->materials[shape].shininess);
+                    uv.x = model->attrib.texcoords[2*idx.texcoord_index + 0];
+                    uv.y = model->attrib.texcoords[2*idx.texcoord_index + 1];
                 }
+                packed.texcoords = glm::packHalf2x16(uv);
+
+                packed.color[0] = packed.color[1] = packed.color[2] = 255;
+                packed.material = material;
+
+                vertices.push_back(packed);
             }
         }
 
         size_t last_index = indices.size() - 1;
 
-        SceneObject theobject;
-        theobject.name                   = model->shapes[shape].name;
-        theobject.first_index            = first_index; // Primeiro índice
-        theobject.num_indices            = last_index - first_index + 1; // Número de indices
-        theobject.rendering_mode         = GL_TRIANGLES;       // Índices correspondem ao tipo de rasterização GL_TRIANGLES.
-        theobject.vertex_array_object_id = vertex_array_object_id;
-        theobject.bbox_min               = bbox_min;
-        theobject.bbox_max               = bbox_max;
-        theobject.vertices               = vertices;
+        // Ainda sem soldar: o vértice i é o índice i
+        if (spherical_albedo != NULL)
+        {
+            glm::vec3 bbox_center = (bbox_min + bbox_max) / 2.0f;
+            for (size_t i = first_index; i <= last_index; ++i)
+            {
+                glm::vec3 position(vertices[i].position[0], vertices[i].position[1], vertices[i].position[2]);
+                glm::vec3 Kd = SampleImageBilinear(*spherical_albedo, SphericalMapping(bbox_center, position));
+                for (int c = 0; c < 3; ++c)
+                    vertices[i].color[c] = LinearToGamma8(Kd[c]);
+            }
+        }
 
-        g_VirtualScene[model->shapes[shape].name] = theobject;
+        MeshShape theshape;
+        std::memset(&theshape, 0, sizeof(theshape)); // o cache guarda os bytes como estão
+        strncpy(theshape.name, model->shapes[shape].name.c_str(), MESH_SHAPE_NAME_SIZE - 1);
+        theshape.first_index = first_index; // Primeiro índice
+        theshape.num_indices = last_index - first_index + 1; // Número de indices
+        theshape.bbox_min    = bbox_min;
+        theshape.bbox_max    = bbox_max;
+        mesh->shapes.push_back(theshape);
     }
 
-    GLuint VBO_model_coefficients_id;
-    glGenBuffers(1, &VBO_model_coefficients_id);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_model_coefficients_id);
-    glBufferData(GL_ARRAY_BUFFER, model_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, model_coefficients.size() * sizeof(float), model_coefficients.data());
-    GLuint location = 0; // "(location = 0)" em "shader_vertex.glsl"
-    GLint  number_of_dimensions = 4; // vec4 em "shader_vertex.glsl"
-    glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(location);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // Até aqui cada canto de triângulo é um vértice (indices[i] == i)
+    std::vector<uint32_t> welded;
+    size_t num_welded = generateVertexRemap(welded, vertices.data(), vertices.size(), sizeof(PackedVertex));
+    std::vector<PackedVertex> welded_vertices(num_welded);
+    remapVertexBuffer(welded_vertices.data(), vertices.data(), vertices.size(), sizeof(PackedVertex), welded);
+    for (size_t i = 0; i < indices.size(); ++i)
+        indices[i] = welded[i];
 
-    if ( !normal_coefficients.empty() )
+    for (size_t shape = 0; shape < mesh->shapes.size(); ++shape)
     {
-        GLuint VBO_normal_coefficients_id;
-        glGenBuffers(1, &VBO_normal_coefficients_id);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_normal_coefficients_id);
-        glBufferData(GL_ARRAY_BUFFER, normal_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, normal_coefficients.size() * sizeof(float), normal_coefficients.data());
-        location = 1; // "(location = 1)" em "shader_vertex.glsl"
-        number_of_dimensions = 4; // vec4 em "shader_vertex.glsl"
-        glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(location);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        const MeshShape& theshape = mesh->shapes[shape];
+        GLuint* shape_indices = &indices[theshape.first_index];
+
+        VertexCacheStats only_welded = analyzeVertexCache(shape_indices, theshape.num_indices, num_welded);
+        optimizeVertexCache(shape_indices, theshape.num_indices, num_welded);
+        optimizeOverdraw(shape_indices, theshape.num_indices, welded_vertices[0].position, num_welded, sizeof(PackedVertex));
+        VertexCacheStats optimized = analyzeVertexCache(shape_indices, theshape.num_indices, num_welded);
+
+        // Sem índices, cada canto é transformado: ACMR 3 e ATVR 1
+        printf("Malha \"%s\": %d triângulos, vertex shader %d -> %d vezes (ACMR 3.00 -> %.2f, ATVR 1.00 -> %.2f; só soldando, ACMR %.2f)\n",
+               theshape.name, (int)optimized.triangles, (int)theshape.num_indices,
+               (int)optimized.transformed, optimized.acmr, optimized.atvr, only_welded.acmr);
     }
 
-    if ( !texture_coefficients.empty() )
-    {
-        GLuint VBO_texture_coefficients_id;
-        glGenBuffers(1, &VBO_texture_coefficients_id);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_texture_coefficients_id);
-        glBufferData(GL_ARRAY_BUFFER, texture_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, texture_coefficients.size() * sizeof(float), texture_coefficients.data());
-        location = 2; // "(location = 2)" em "shader_vertex.glsl"
-        number_of_dimensions = 2; // vec2 em "shader_vertex.glsl"
-        glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(location);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-    }
+    // Vértices na ordem de uso, para leitura sequencial
+    std::vector<uint32_t> fetch_order;
+    size_t num_vertices = optimizeVertexFetch(fetch_order, indices.data(), indices.size(), num_welded);
+    mesh->vertices.resize(num_vertices);
+    for (size_t v = 0; v < num_welded; ++v)
+        if (fetch_order[v] != ~0u)
+            mesh->vertices[fetch_order[v]] = welded_vertices[v];
 
-    if (!material_diffuse_coefficients.empty())
-    {
-        GLuint VBO_material_coefficients_id;
-        glGenBuffers(1, &VBO_material_coefficients_id);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_material_coefficients_id);
-        glBufferData(GL_ARRAY_BUFFER, material_diffuse_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, material_diffuse_coefficients.size() * sizeof(float), material_diffuse_coefficients.data());
-        location = 3; // "(location = 3)" em "shader_vertex.glsl"
-        number_of_dimensions = 3; // vec3 em "shader_vertex.glsl"
-        glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(location);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-    }
-    if (!material_speculate_coefficients.empty())
+    // Asteroides distantes ocupam poucos pixels; desenhamos versões simplificadas
+    if (options & MESH_LEVELS_OF_DETAIL)
     {
-        GLuint VBO_material_coefficients_id;
-        glGenBuffers(1, &VBO_material_coefficients_id);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_material_coefficients_id);
-        glBufferData(GL_ARRAY_BUFFER, material_speculate_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, material_speculate_coefficients.size() * sizeof(float), material_speculate_coefficients.data());
-        location = 4; // "(location = 4)" em "shader_vertex.glsl"
-        number_of_dimensions = 3; // vec3 em "shader_vertex.glsl"
-        glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(location);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        // Vértice em mesh->vertices de cada canto de triângulo, na ordem do ".obj"
+        std::vector<GLuint> corner_vertices(welded.size());
+        for (size_t i = 0; i < welded.size(); ++i)
+            corner_vertices[i] = fetch_order[welded[i]];
+        GenerateLevelsOfDetail(model, corner_vertices, mesh);
     }
-    if (!material_environment_coefficients.empty())
+
+    if (options & MESH_COLLISION)
+        mesh->collision = CollectModelVertices(model);
+}
+
+// Envia um modelo processado por BuildMesh() para a GPU: um VAO com um VBO
+// de vértices e um de índices, e um VAO por buffer de níveis de detalhe.
+// Cada MeshShape vira um objeto em g_VirtualScene, com MeshIds
+// consecutivos; retorna o MeshId do primeiro. Os materiais do modelo são
+// acrescentados a g_Materials.
+MeshId AddMeshToVirtualScene(const MeshView& mesh)
+{
+    MeshId first_mesh = g_VirtualScene.size();
+
+    // O material k do modelo é g_Materials[material_base + k]
+    int material_base = 0;
+    if (mesh.materials.size > 0)
     {
-        GLuint VBO_material_coefficients_id;
-        glGenBuffers(1, &VBO_material_coefficients_id);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_material_coefficients_id);
-        glBufferData(GL_ARRAY_BUFFER, material_environment_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, material_environment_coefficients.size() * sizeof(float), material_environment_coefficients.data());
-        location = 5; // "(location = 5)" em "shader_vertex.glsl"
-        number_of_dimensions = 3; // vec3 em "shader_vertex.glsl"
-        glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(location);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        if (g_Materials.size() + mesh.materials.size <= MAX_MATERIALS)
+        {
+            material_base = g_Materials.size() - 1;
+            g_Materials.insert(g_Materials.end(), mesh.materials.data, mesh.materials.data + mesh.materials.size);
+        }
+        else
+            fprintf(stderr, "WARNING: more than %d materials, ignoring the materials of a model.\n", MAX_MATERIALS);
     }
-    if (!material_speculate_coefficients.empty())
-    {
-        GLuint VBO_material_coefficients_id;
-        glGenBuffers(1, &VBO_material_coefficients_id);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_material_coefficients_id);
-        glBufferData(GL_ARRAY_BUFFER, material_speculate_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, material_speculate_coefficients.size() * sizeof(float), material_speculate_coefficients.data());
-        location = 6; // "(location = 6)" em "shader_vertex.glsl"
-        number_of_dimensions = 1; // float em "shader_vertex.glsl"
-        glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
+
+    GLuint vertex_array_object_id;
+    glGenVertexArrays(1, &vertex_array_object_id);
+    glBindVertexArray(vertex_array_object_id);
+
+    GLuint VBO_vertices_id;
+    glGenBuffers(1, &VBO_vertices_id);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO_vertices_id);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size * sizeof(PackedVertex), mesh.vertices.data, GL_STATIC_DRAW);
+
+    // Os "(location = N)" em "shader_vertex.glsl"
+    const GLsizei stride = sizeof(PackedVertex);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, position)); // w = 1
+    glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal));
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, texcoords));
+    glVertexAttribPointer(3, 3, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(PackedVertex, color));
+    glVertexAttribIPointer(4, 1, GL_UNSIGNED_BYTE, stride, (void*)offsetof(PackedVertex, material));
+    for (GLuint location = 0; location <= 4; ++location)
         glEnableVertexAttribArray(location);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     GLuint indices_id;
     glGenBuffers(1, &indices_id);
 
     // "Ligamos" o buffer. Note que o tipo agora é GL_ELEMENT_ARRAY_BUFFER.
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_id);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(GLuint), indices.data());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size * sizeof(GLuint), mesh.indices.data, GL_STATIC_DRAW);
     // glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); // XXX Errado!
     //
 
     // "Desligamos" o VAO, evitando assim que operações posteriores venham a
     // alterar o mesmo. Isso evita bugs.
     glBindVertexArray(0);
+
+    for (size_t shape = 0; shape < mesh.shapes.size; ++shape)
+    {
+        const MeshShape& theshape = mesh.shapes[shape];
+
+        SceneObject theobject;
+        theobject.first_index            = theshape.first_index; // Primeiro índice
+        theobject.num_indices            = theshape.num_indices; // Número de indices
+        theobject.rendering_mode         = GL_TRIANGLES;       // Índices correspondem ao tipo de rasterização GL_TRIANGLES.
+        theobject.vertex_array_object_id = vertex_array_object_id;
+        theobject.bbox_min               = theshape.bbox_min;
+        theobject.bbox_max               = theshape.bbox_max;
+        theobject.bounding_radius        = glm::length(glm::max(glm::abs(theshape.bbox_min), glm::abs(theshape.bbox_max)));
+        theobject.material_base          = material_base;
+
+        LevelOfDetail full;
+        full.vertex_array_object_id = vertex_array_object_id;
+        full.first_index            = theobject.first_index;
+        full.num_indices            = theobject.num_indices;
+        theobject.lods.push_back(full);
+
+        g_VirtualSceneNames[theshape.name] = g_VirtualScene.size();
+        g_VirtualScene.push_back(theobject);
+    }
+
+    if (mesh.levels.size > 0)
+    {
+        GLuint lod_indices_id;
+        glGenBuffers(1, &lod_indices_id);
+        glBindBuffer(GL_ARRAY_BUFFER, lod_indices_id); // sem VAO ligado, para não mexer no GL_ELEMENT_ARRAY_BUFFER de nenhum
+        glBufferData(GL_ARRAY_BUFFER, mesh.lod_indices.size * sizeof(GLuint), mesh.lod_indices.data, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        for (size_t i = 0; i < mesh.levels.size; i++)
+        {
+            SceneObject& object = g_VirtualScene[first_mesh + mesh.levels[i].shape];
+            LevelOfDetail level;
+            level.vertex_array_object_id = CloneVertexArray(vertex_array_object_id, lod_indices_id);
+            level.first_index            = mesh.levels[i].first_index;
+            level.num_indices            = mesh.levels[i].num_indices;
+            object.lods.push_back(level);
+        }
+    }
+
+    return first_mesh;
 }
 
-// Carrega as texturas do cube
-unsigned int loadCubemap(std::vector<std::string> faces)
+// Retorna o modelo "filename" processado por BuildMesh(). Na primeira vez o
+// resultado é gravado em "filename.cache"; nas seguintes, enquanto o
+// ".obj", o ".mtl" de mesmo nome e "albedo_filename" não mudarem, ele é
+// lido do cache, sem interpretar texto, soldar vértices nem simplificar
+// malhas. A MeshView aponta para "cache" (mapeado na memória) ou para
+// "data", que precisam continuar abertos enquanto ela for usada.
+MeshView LoadMeshData(const char* filename, const char* basepath, const char* albedo_filename, unsigned int options,
+                      MeshCacheFile* cache, MeshData* data)
 {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    int width, height, nrChannels;
-    for (unsigned int i = 0; i < faces.size(); i++)
+    std::vector<std::string> sources;
+    sources.push_back(filename);
+    std::string mtl = filename;
+    if (mtl.size() > 4 && mtl.compare(mtl.size() - 4, 4, ".obj") == 0)
     {
-        unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        if (data)
+        mtl.replace(mtl.size() - 4, 4, ".mtl");
+        if (FILE* file = fopen(mtl.c_str(), "rb"))
         {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
+            fclose(file);
+            sources.push_back(mtl);
         }
+    }
+    if (albedo_filename != NULL)
+        sources.push_back(albedo_filename);
+
+    std::string cache_filename = std::string(filename) + ".cache";
+    uint32_t version = (MESH_CACHE_VERSION << 8) | options;
+
+    MeshView view;
+    if (cache->open(cache_filename.c_str(), sources, version))
+    {
+        view.vertices.data    = cache->chunkArray<PackedVertex>(MESH_CHUNK_VERTICES, &view.vertices.size);
+        view.indices.data     = cache->chunkArray<GLuint>(MESH_CHUNK_INDICES, &view.indices.size);
+        view.shapes.data      = cache->chunkArray<MeshShape>(MESH_CHUNK_SHAPES, &view.shapes.size);
+        view.materials.data   = cache->chunkArray<Material>(MESH_CHUNK_MATERIALS, &view.materials.size);
+        view.lod_indices.data = cache->chunkArray<GLuint>(MESH_CHUNK_LOD_INDICES, &view.lod_indices.size);
+        view.levels.data      = cache->chunkArray<MeshLevel>(MESH_CHUNK_LEVELS, &view.levels.size);
+        view.collision.data   = cache->chunkArray<glm::vec4>(MESH_CHUNK_COLLISION, &view.collision.size);
+        printf("Carregando modelo \"%s\" do cache... OK.\n", filename);
+        return view;
+    }
+
+    ObjModel model(filename, basepath, true, g_LoaderJobs);
+    ComputeNormals(&model);
+
+    ImageRGB albedo;
+    if (albedo_filename != NULL)
+        LoadImageRGB(albedo_filename, &albedo);
+
+    BuildMesh(&model, albedo_filename != NULL ? &albedo : NULL, options, data);
+
+    MeshCacheWriter writer;
+    writer.addArray(MESH_CHUNK_VERTICES, data->vertices);
+    writer.addArray(MESH_CHUNK_INDICES, data->indices);
+    writer.addArray(MESH_CHUNK_SHAPES, data->shapes);
+    writer.addArray(MESH_CHUNK_MATERIALS, data->materials);
+    writer.addArray(MESH_CHUNK_LOD_INDICES, data->lod_indices);
+    writer.addArray(MESH_CHUNK_LEVELS, data->levels);
+    writer.addArray(MESH_CHUNK_COLLISION, data->collision);
+    if (!writer.write(cache_filename.c_str(), sources, version))
+        fprintf(stderr, "WARNING: cannot write mesh cache \"%s\".\n", cache_filename.c_str());
+
+    view.vertices    = data->vertices;
+    view.indices     = data->indices;
+    view.shapes      = data->shapes;
+    view.materials   = data->materials;
+    view.lod_indices = data->lod_indices;
+    view.levels      = data->levels;
+    view.collision   = data->collision;
+    return view;
+}
+
+// Carrega um modelo com LoadMeshData() em segundo plano e o envia à GPU
+// com AddMeshToVirtualScene(). Com MESH_COLLISION, os triângulos vão para
+// "collision", que precisa existir até o fim do carregamento.
+void LoadModel(AssetQueue& assets, const char* filename, const char* basepath, const char* albedo_filename,
+               unsigned int options, std::vector<glm::vec4>* collision)
+{
+    // Cópias, já que a carga roda depois do retorno
+    std::string name = filename;
+    std::string base = basepath != NULL ? basepath : "";
+    std::string albedo = albedo_filename != NULL ? albedo_filename : "";
+    bool has_base = basepath != NULL;
+    bool has_albedo = albedo_filename != NULL;
+
+    assets.load([=](std::vector<AssetQueue::Upload>& uploads) {
+        struct Payload
+        {
+            MeshCacheFile cache;
+            MeshData data;
+            MeshView view;
+        };
+        std::shared_ptr<Payload> payload = std::make_shared<Payload>();
+        payload->view = LoadMeshData(name.c_str(), has_base ? base.c_str() : NULL,
+                                     has_albedo ? albedo.c_str() : NULL, options,
+                                     &payload->cache, &payload->data);
+
+        uploads.push_back([payload, collision] {
+            AddMeshToVirtualScene(payload->view);
+            if (collision != NULL)
+                collision->assign(payload->view.collision.data,
+                                  payload->view.collision.data + payload->view.collision.size);
+        });
+    });
+}
+
+// As seis imagens do cube map em "directory", na ordem das faces do OpenGL
+// (+X, -X, +Y, -Y, +Z, -Z). Cada face pode ser ".png" ou ".jpg".
+std::vector<std::string> CubemapFaces(const std::string& directory)
+{
+    static const char* const names[6] = { "right", "left", "top", "bottom", "front", "back" };
+
+    std::vector<std::string> faces;
+    for (int i = 0; i < 6; i++)
+    {
+        std::string face = directory + names[i] + ".png";
+        if (FILE* file = fopen(face.c_str(), "rb"))
+            fclose(file);
         else
+            face = directory + names[i] + ".jpg";
+        faces.push_back(face);
+    }
+    return faces;
+}
+
+// Carrega as texturas do cube map em segundo plano, com todos os níveis de
+// mipmap, no formato g_TextureFormat (veja LoadCookedTexture(); as faces
+// são preparadas em paralelo e, com "use_cache", guardadas em cache). Cada
+// face é um envio separado, para dividir o envio entre quadros. "texture"
+// recebe o nome da textura no primeiro envio.
+void loadCubemap(AssetQueue& assets, const std::vector<std::string>& faces, GLuint* texture, bool use_cache)
+{
+    int format = g_TextureFormat;
+    assets.load([faces, format, texture, use_cache](std::vector<AssetQueue::Upload>& uploads) {
+        std::shared_ptr<CookedTexture> cooked = std::make_shared<CookedTexture>();
+        LoadCookedTexture(faces, format, use_cache, cooked.get());
+
+        uploads.push_back([cooked, texture] {
+            glGenTextures(1, texture);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, *texture);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, cooked->info[3] - 1);
+        });
+        for (int i = 0; i < (int)faces.size(); i++)
         {
-            std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-            stbi_image_free(data);
+            uploads.push_back([cooked, texture, i] {
+                glBindTexture(GL_TEXTURE_CUBE_MAP, *texture);
+                UploadCookedImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, *cooked, i, false);
+            });
         }
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    });
+}
 
-    return textureID;
+void PrintUsage(const char* program)
+{
+    fprintf(stderr,
+            "Usage: %s [options] [model.obj]\n"
+            "  --headless            run only the simulation, without a window\n"
+            "  --ticks N             ticks simulated in headless mode\n"
+            "  --seed S              asteroid generation seed\n"
+            "  --asteroids N         maximum number of asteroids\n"
+            "  --threads N           simulation and loading threads (0 = one per core)\n"
+            "  --skybox NAME         cube map from data/cubesmaps/NAME\n"
+            "  --no-texture-cache    always decode and compress textures\n"
+            "  --texture-format F    rgb, bc1 or bc7\n",
+            program);
 }
 
-// gerar os asteroides em um raio maximo com relação a nave
-// e garantir que eles venha em direção a nave
-Asteroid generateNewAsteroid() {
-    // converter para coordenadas esfericas
-    glm::vec4 c = spaceship.position;
-    glm::vec4 displacement = c - glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-
-    float rho = ASTEROIDS_SPAWN_DISTANCE;
-    float phi = PHI_MIN + static_cast <float> (rand()) /(static_cast<float>(RAND_MAX/(PHI_MAX-PHI_MIN)));
-    float theta = THETA_MIN + static_cast <float> (rand()) /(static_cast<float>(RAND_MAX/(THETA_MAX-THETA_MIN)));
-    float anti_theta = theta > 0 ? theta - PI : theta + PI;
-    float anti_phi = -phi;
-
-    glm::vec4 start_position = toCartesianFromSpherical(rho, theta, phi) + displacement;
-    glm::vec4 end_position = toCartesianFromSpherical(rho, anti_theta, anti_phi) + displacement;
-
-    float phi_gap = PI/4;
-    float rho2 = 3 * ASTEROIDS_SPAWN_DISTANCE / 2;
-    float theta2 = THETA_MIN + static_cast <float> (rand()) /(static_cast<float>(RAND_MAX/(THETA_MAX-THETA_MIN)));
-    float phi2 = phi > 0 ? phi - phi_gap : phi + phi_gap;
-    float anti_theta2 = theta2 > 0 ? theta2 - PI : theta2 + PI;
-    float anti_phi2 = -phi2;
-
-    glm::vec4 start_middle_position = toCartesianFromSpherical(rho2, theta2, phi2) + displacement;
-    glm::vec4 end_middle_position = toCartesianFromSpherical(rho2, anti_theta2, anti_phi2) + displacement;
-
-    std::vector<glm::vec4> controlPoints = {start_position,
-                                            start_middle_position,
-                                            end_middle_position,
-                                            end_position};
-    Asteroid newAsteroid(start_position, controlPoints);
-
-    return newAsteroid;
+// strtoul() aceita "-1" (dando um número enorme) e devolve 0 para texto que
+// não é número; aqui os dois casos são erros
+bool ParseUnsigned(const char* text, unsigned long max, unsigned long* value)
+{
+    if (!isdigit((unsigned char)text[0]))
+        return false;
+    char* end;
+    errno = 0;
+    unsigned long result = strtoul(text, &end, 10);
+    if (errno != 0 || *end != '\0' || result > max)
+        return false;
+    *value = result;
+    return true;
 }
 
 void gameOver() {
@@ -1070,6 +2014,62 @@ void gameOver() {
     std::exit(0);
 
 }
+
+// Roda a simulação sem janela e sem contexto OpenGL, o mais rápido possível,
+// com um piloto automático determinístico. Útil para medir ticks/segundo e
+// fazer profiling em máquinas sem display.
+int RunHeadless(unsigned long ticks, unsigned int seed, size_t max_asteroids, unsigned int threads)
+{
+    // Só os triângulos de colisão da nave; o mesmo cache do modo com janela
+    MeshCacheFile spaceship_cache;
+    MeshData spaceship_data;
+    MeshView spaceship = LoadMeshData("../../data/SpaceShip.obj", "../../data/", NULL, MESH_COLLISION,
+                                      &spaceship_cache, &spaceship_data);
+
+    GameWorld world(seed, threads);
+    world.setSpaceshipMesh(std::vector<glm::vec4>(spaceship.collision.data, spaceship.collision.data + spaceship.collision.size));
+    world.maxAsteroids = max_asteroids;
+    world.asteroids.reserve(max_asteroids);
+
+    printf("Headless: %lu ticks, seed %u, dt %.4fs, %d asteroids, %u threads\n", ticks, seed,
+           SIMULATION_TIMESTEP, (int)max_asteroids, world.threadCount());
+
+    unsigned long game_over_tick = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long tick = 0; tick < ticks; tick++)
+    {
+        // Piloto automático: mantém velocidade baixa (para que o campo de
+        // asteroides fique denso), alterna curvas a cada 2 segundos e atira
+        // 10 vezes por segundo.
+        world.input.up    = world.spaceship.speed < 1.0f;
+        world.input.left  = (tick / 120) % 2 == 0;
+        world.input.right = !world.input.left;
+        world.input.shoot = tick % 6 == 0;
+
+        world.step(SIMULATION_TIMESTEP);
+
+        if (game_over_tick == 0 && world.isGameOver())
+            game_over_tick = world.ticks;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    printf("Simulated %.1fs in %.3fs: %.0f ticks/s\n", world.time, seconds, ticks / seconds);
+    printf("Score %d, life %d, asteroids %d, bullets %d\n", world.player.score,
+           world.spaceship.life, (int)world.asteroids.size(), (int)world.bullets.size());
+    printf("Spaceship at (%.4f, %.4f, %.4f)\n", world.spaceship.position.x,
+           world.spaceship.position.y, world.spaceship.position.z);
+    if (game_over_tick != 0)
+        printf("Game over at tick %lu\n", game_over_tick);
+
+    const CollisionStats& stats = world.collisionStats;
+    printf("Collisions (candidates/hits): spaceship %lu/%lu, asteroid-asteroid %lu/%lu, asteroid-bullet %lu/%lu\n",
+           stats.spaceshipCandidates, stats.spaceshipHits,
+           stats.asteroidCandidates, stats.asteroidHits,
+           stats.bulletCandidates, stats.bulletHits);
+
+    return 0;
+}
 ///////////////////////////////////////////////
 
 // Definição da função que será chamada sempre que a janela do sistema
@@ -1227,12 +2227,13 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mod)
 
     /////////////////////
     // Controles da nave
-    leftKeyPressed = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
-    rightKeyPressed = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
-    topKeyPressed = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
-    downKeyPressed = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+    GameInput& input = g_World->input;
+    input.left = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+    input.right = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+    input.up = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+    input.down = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
     if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-        spacePressed = true;
+        input.shoot = true;
     }
 }
 
@@ -1284,7 +2285,7 @@ void TextRendering_ShowSpaceshipLife(GLFWwindow* window)
         return;
 
     std::stringstream ss;
-    ss << spaceship.life;
+    ss << g_World->spaceship.life;
     std::string life;
     ss >> life;
 
@@ -1300,7 +2301,7 @@ void TextRendering_ShowPlayerInfo(GLFWwindow* window)
         return;
 
     std::stringstream ss;
-    ss << player.score;
+    ss << g_World->player.score;
     std::string score;
     ss >> score;
 
@@ -1310,6 +2311,67 @@ void TextRendering_ShowPlayerInfo(GLFWwindow* window)
     TextRendering_PrintString(window, "Score: " + score, -1.0f, -0.99f, 1.0f);
 }
 
+// Escrevemos abaixo do fps quantos desenhos a RenderQueue emitiu no último
+// quadro e quantas trocas de estado foram feitas e evitadas.
+void TextRendering_ShowRenderStats(GLFWwindow* window, const RenderStats& stats)
+{
+    if ( !g_ShowInfoText )
+        return;
+
+    char buffer[80];
+    int numchars = snprintf(buffer, 80, "%u draws %u binds %u avoided", stats.draws, stats.binds, stats.bindsAvoided);
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    TextRendering_PrintString(window, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-2*lineheight, 1.0f);
+}
+
+// Escrevemos abaixo das estatísticas da RenderQueue quantos tiros e
+// asteroides passaram pelo teste de visibilidade no último quadro.
+void TextRendering_ShowCullStats(GLFWwindow* window, size_t visible, size_t culled)
+{
+    if ( !g_ShowInfoText )
+        return;
+
+    char buffer[80];
+    int numchars = snprintf(buffer, 80, "%u visible %u culled", (unsigned int)visible, (unsigned int)culled);
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    TextRendering_PrintString(window, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-3*lineheight, 1.0f);
+}
+
+// Escrevemos no centro da tela quantos assets já foram carregados
+void TextRendering_ShowLoadingProgress(GLFWwindow* window, size_t loaded, size_t total)
+{
+    char buffer[40];
+    int numchars = snprintf(buffer, 40, "Carregando... %d/%d", (int)loaded, (int)total);
+
+    float charwidth = TextRendering_CharWidth(window);
+
+    TextRendering_PrintString(window, buffer, -numchars*charwidth/2.0f, 0.0f, 1.0f);
+}
+
+// Escrevemos abaixo quantos bytes de dados dinâmicos (instâncias e texto)
+// foram enviados no último quadro, e se o StreamBuffer precisou trocar de
+// memória (GPU atrasada) ou crescer.
+void TextRendering_ShowStreamStats(GLFWwindow* window, const StreamStats& stats)
+{
+    if ( !g_ShowInfoText )
+        return;
+
+    char buffer[80];
+    int numchars = snprintf(buffer, 80, "%.1f KB streamed %u orphans %u grows",
+                            stats.bytes / 1024.0f, stats.orphans, stats.grows);
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    TextRendering_PrintString(window, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-4*lineheight, 1.0f);
+}
+
 
 
 // set makeprg=cd\ ..\ &&\ make\ run\ >/dev/null
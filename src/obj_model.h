@@ -6,6 +6,8 @@
 
 #include <tiny_obj_loader.h>
 
+#include "ObjLoader.h"
+
 // Estrutura que representa um modelo geomtrico carregado a partir de um
 // arquivo ".obj". Veja https://en.wikipedia.org/wiki/Wavefront_.obj_file .
 struct ObjModel
@@ -16,12 +18,18 @@ struct ObjModel
 
     // Este construtor l o modelo de um arquivo utilizando a biblioteca tinyobjloader.
     // Veja: https://github.com/syoyo/tinyobjloader
-    ObjModel(const char* filename, const char* basepath = NULL, bool triangulate = true)
+    // Com "jobs", o arquivo  interpretado em paralelo por loadObjParallel(),
+    // com o mesmo resultado.
+    ObjModel(const char* filename, const char* basepath = NULL, bool triangulate = true, JobSystem* jobs = NULL)
     {
         printf("Carregando modelo \"%s\"... ", filename);
 
         std::string err;
-        bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, filename, basepath, triangulate);
+        bool ret;
+        if (jobs != NULL)
+            ret = loadObjParallel(&attrib, &shapes, &materials, &err, filename, basepath, triangulate, *jobs);
+        else
+            ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, filename, basepath, triangulate);
 
         if (!err.empty())
             fprintf(stderr, "\n%s\n", err.c_str());
@@ -21,10 +21,16 @@ in vec3 material_speculate;
 in vec3 material_environment;
 in float material_specular_exponent;
 
-// Matrizes computadas no código C++ e enviadas para a GPU
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Dados da câmera e da luz, iguais para todos os objetos do quadro. Veja
+// FrameUniformData em "FrameUniforms.h".
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec4 camera_position;
+    vec4 light_direction;
+};
 
 // Identificador que define qual objeto está sendo desenhado no momento
 #define SPACESHIP 0
@@ -38,15 +44,8 @@ uniform vec4 bbox_min;
 uniform vec4 bbox_max;
 
 // Variáveis para acesso das imagens de textura
-uniform sampler2D TextureImage1; // steel
-uniform sampler2D TextureImage2;
-
-// Constantes
-#define M_PI   3.14159265358979323846
-#define M_PI_2 1.57079632679489661923
-
-// functions declarations
-void spherical_mapping(in vec4 center, in vec4 position, out float U, out float V);
+uniform sampler2D TextureImage0; // steel
+uniform sampler2D TextureImage1;
 
 // O valor de saída ("out") de um Fragment Shader é a cor final do fragmento.
 out vec3 color;
@@ -58,11 +57,6 @@ void main()
         return;
     }
 
-    // Obtemos a posição da câmera utilizando a inversa da matriz que define o
-    // sistema de coordenadas da câmera.
-    vec4 origin = vec4(0.0, 0.0, 0.0, 1.0);
-    vec4 camera_position = inverse(view) * origin;
-
     // O fragmento atual é coberto por um ponto que percente à superfície de um
     // dos objetos virtuais da cena. Este ponto, p, possui uma posição no
     // sistema de coordenadas global (World coordinates). Esta posição é obtida
@@ -75,7 +69,7 @@ void main()
     vec4 n = normalize(normal);
 
     // Vetor que define o sentido da fonte de luz em relação ao ponto atual.
-    vec4 l = normalize(vec4(1.0,1.0,0.0,0.0));
+    vec4 l = light_direction;
 
     // Vetor que define o sentido da câmera em relação ao ponto atual.
     vec4 v = normalize(camera_position - p);
@@ -97,7 +91,7 @@ void main()
             float y = (position_model.y - bbox_min.y) / (bbox_max.y - bbox_min.y);
             float U = x;
             float V = y;
-            Kd = texture(TextureImage1, vec2(U,V)).rgb;
+            Kd = texture(TextureImage0, vec2(U,V)).rgb;
         } else {
             Kd = material_diffuse;
         }
@@ -134,14 +128,3 @@ void main()
     // Veja https://en.wikipedia.org/w/index.php?title=Gamma_correction&oldid=751281772#Windows.2C_Mac.2C_sRGB_and_TV.2Fvideo_standard_gammas
     color = pow(color, vec3(1.0,1.0,1.0)/2.2);
 }
-
-void spherical_mapping(in vec4 center, in vec4 position, out float U, out float V) {
-    vec4 p_line = center + normalize(position - center);
-    vec4 p_vector = p_line - center;
-    float phi = asin(p_vector.y);
-    float theta = atan(p_vector.x, p_vector.z);
-
-    U = (theta + M_PI) / (2*M_PI);
-    V = (phi + M_PI_2) / M_PI;
-}
-
@@ -1,20 +1,40 @@
 #version 330 core
 
 // Atributos de vrtice recebidos como entrada ("in") pelo Vertex Shader.
-// Veja a funo BuildTrianglesAndAddToVirtualScene() em "main.cpp".
+// Veja a funo BuildTrianglesAndAddToVirtualScene() e a estrutura
+// PackedVertex em "main.cpp".
 layout (location = 0) in vec4 model_coefficients;
 layout (location = 1) in vec4 normal_coefficients;
 layout (location = 2) in vec2 texture_coefficients;
-// material
-layout (location = 3) in vec3 material_diffuse_coefficients;
-layout (location = 4) in vec3 material_speculate_coefficients;
-layout (location = 5) in vec3 material_environment_coefficients;
-layout (location = 6) in float material_specular_exponent_coefficients;
+layout (location = 3) in vec3 vertex_color; // com gamma 2.2
+layout (location = 4) in uint material_index;
+// Matriz "model" por instncia (ocupa as locations 7 a 10). Veja a funo
+// AttachInstanceAttributes() em "main.cpp".
+layout (location = 7) in mat4 instance_model;
 
 // Matrizes computadas no cdigo C++ e enviadas para a GPU
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform int instanced; // 1 = usa instance_model no lugar de model
+
+// Dados da cmera e da luz, iguais para todos os objetos do quadro. Veja
+// FrameUniformData em "FrameUniforms.h".
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    vec4 camera_position;
+    vec4 light_direction;
+};
+
+// Materiais de todos os modelos. O material_index do vrtice  do modelo
+// (0 = nenhum); material_base o leva para estes arrays. Veja a funo
+// UploadMaterials() e SceneObject::material_base em "main.cpp".
+#define MAX_MATERIALS 64
+uniform vec4 materials_Kd[MAX_MATERIALS];
+uniform vec4 materials_Ks[MAX_MATERIALS]; // w = expoente especular
+uniform vec4 materials_Ka[MAX_MATERIALS];
+uniform int material_base;
 
 // Identificador que define qual objeto est sendo desenhado no momento
 #define SPACESHIP 0
@@ -22,13 +42,6 @@ uniform mat4 projection;
 #define BULLET    2
 uniform int object_id;
 
-// Parmetros da axis-aligned bounding box (AABB) do modelo
-uniform vec4 bbox_min;
-uniform vec4 bbox_max;
-
-// Variveis para acesso das imagens de textura
-uniform sampler2D TextureImage0;
-
 // Atributos de vrtice que sero gerados como sada ("out") pelo Vertex Shader.
 // ** Estes sero interpolados pelo rasterizador! ** gerando, assim, valores
 // para cada fragmento, os quais sero recebidos como entrada pelo Fragment
@@ -44,13 +57,6 @@ out vec3 material_speculate;
 out vec3 material_environment;
 out float material_specular_exponent;
 
-// Constantes
-#define M_PI   3.14159265358979323846
-#define M_PI_2 1.57079632679489661923
-
-// functions declarations
-void spherical_mapping(in vec4 center, in vec4 position, out float U, out float V);
-
 void main()
 {
     // A varivel gl_Position define a posio final de cada vrtice
@@ -65,7 +71,9 @@ void main()
     // deste Vertex Shader, a placa de vdeo (GPU) far a diviso por W. Veja
     // slide 189 do documento "Aula_09_Projecoes.pdf".
 
-    gl_Position = projection * view * model * model_coefficients;
+    mat4 M = (instanced == 1) ? instance_model : model;
+
+    gl_Position = view_projection * M * model_coefficients;
 
     // Como as variveis acima  (tipo vec4) so vetores com 4 coeficientes,
     // tambm  possvel acessar e modificar cada coeficiente de maneira
@@ -82,40 +90,41 @@ void main()
     // rasterizador para gerar atributos nicos para cada fragmento gerado.
 
     // Posio do vrtice atual no sistema de coordenadas global (World).
-    position_world = model * model_coefficients;
+    position_world = M * model_coefficients;
 
     // Posio do vrtice atual no sistema de coordenadas local do modelo.
     position_model = model_coefficients;
 
     // Normal do vrtice atual no sistema de coordenadas global (World).
     // Veja slide 107 do documento "Aula_07_Transformacoes_Geometricas_3D.pdf".
-    normal = inverse(transpose(model)) * normal_coefficients;
+    // As matrizes por instncia s tm rotao, translao e escala
+    // uniforme, ento mat3(M) preserva a direo da normal e evita uma
+    // inversa por vrtice.
+    if (instanced == 1)
+        normal = vec4(mat3(M) * normal_coefficients.xyz, 0.0);
+    else
+        normal = inverse(transpose(M)) * normal_coefficients;
     normal.w = 0.0;
 
     // Coordenadas de textura obtidas do arquivo OBJ (se existirem!)
     texcoords = texture_coefficients;
 
-    material_diffuse           = material_diffuse_coefficients;
-    material_speculate         = material_speculate_coefficients;
-    material_environment       = material_environment_coefficients;
-    material_specular_exponent = material_specular_exponent_coefficients;
+    int material = material_index == 0u ? 0 : min(material_base + int(material_index), MAX_MATERIALS - 1);
+    material_diffuse           = materials_Kd[material].rgb;
+    material_speculate         = materials_Ks[material].rgb;
+    material_environment       = materials_Ka[material].rgb;
+    material_specular_exponent = materials_Ks[material].w;
 
     if (object_id == BULLET) {
         gouraud_color = vec3(1.0, 0.0, 0.0);
     } else if (object_id == ASTEROID) {
-        vec4 light_position = normalize(vec4(1.0,1.0,0.0,1.0));
-        vec4 l = normalize(light_position);
+        vec4 l = light_direction;
         vec4 n = normalize(normal);
 
-        // Coordenadas de textura U e V
-        float U = 0.0;
-        float V = 0.0;
-
-        vec4 bbox_center = (bbox_min + bbox_max) / 2.0;
-
-        spherical_mapping(bbox_center, model_coefficients, U, V);
-        vec3 Kd = texture(TextureImage0, vec2(U,V)).rgb;
-        vec3 Ka = material_environment_coefficients;
+        // Cor da textura no vrtice, amostrada no carregamento com
+        // mapeamento esfrico. Veja BuildTrianglesAndAddToVirtualScene().
+        vec3 Kd = pow(vertex_color, vec3(2.2));
+        vec3 Ka = material_environment;
 
         // Espectro da fonte de iluminao
         vec3 I = vec3(1.0, 1.0, 1.0);
@@ -135,14 +144,3 @@ void main()
         gouraud_color = vec3(0.0, 0.0, 0.0);
     }
 }
-
-void spherical_mapping(in vec4 center, in vec4 position, out float U, out float V) {
-    vec4 p_line = center + normalize(position - center);
-    vec4 p_vector = p_line - center;
-    float phi = asin(p_vector.y);
-    float theta = atan(p_vector.x, p_vector.z);
-
-    U = (theta + M_PI) / (2*M_PI);
-    V = (phi + M_PI_2) / M_PI;
-}
-
@@ -1,6 +1,7 @@
 // Based on http://hamelot.io/visualization/opengl-text-without-any-external-libraries/
 //   and on https://github.com/rougier/freetype-gl
 #include <string>
+#include <vector>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -10,6 +11,7 @@
 
 #include "utils.h"
 #include "dejavufont.h"
+#include "StreamBuffer.h"
 
 // Esta função cria um programa de GPU, o qual contém obrigatoriamente um
 // Vertex Shader e um Fragment Shader.
@@ -132,15 +134,18 @@ void TextRendering_LoadShader(const GLchar* const shader_string, GLuint shader_i
 }
 
 GLuint textVAO;
-GLuint textVBO;
 GLuint textprogram_id;
 GLuint texttexture_id;
 
-void TextRendering_Init()
+// Os vértices do texto vão para o mesmo StreamBuffer que as instâncias: a
+// string inteira é escrita de uma vez e desenhada com uma só chamada
+StreamBuffer* textstream;
+
+void TextRendering_Init(StreamBuffer* stream)
 {
     GLuint sampler;
 
-    glGenBuffers(1, &textVBO);
+    textstream = stream;
     glGenVertexArrays(1, &textVAO);
     glGenTextures(1, &texttexture_id);
     glGenSamplers(1, &sampler);
@@ -175,8 +180,7 @@ void TextRendering_Init()
 
     glBindVertexArray(textVAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, 24 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, textstream->id());
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
     glEnableVertexAttribArray(0);
     glCheckError();
@@ -201,6 +205,11 @@ void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float
     float sx = scale / width;
     float sy = scale / height;
 
+    // 6 vértices (x, y, s, t) por caractere; reaproveitado entre chamadas
+    struct TextVertex {float x, y, s, t;};
+    static std::vector<TextVertex> vertices;
+    vertices.clear();
+
     for (size_t i = 0; i < str.size(); i++)
     {
         // Find the glyph for the character we are looking for
@@ -227,7 +236,7 @@ void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float
         float s1 = glyph->s1 - 0.5f/dejavufont.tex_width;
         float t1 = glyph->t1 - 0.5f/dejavufont.tex_height;
 
-        struct {float x, y, s, t;} data[6] = {
+        TextVertex data[6] = {
             { x0, y0, s0, t0 },
             { x0, y1, s0, t1 },
             { x1, y1, s1, t1 },
@@ -235,29 +244,35 @@ void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float
             { x1, y1, s1, t1 },
             { x1, y0, s1, t0 }
         };
+        vertices.insert(vertices.end(), data, data + 6);
 
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        x += (glyph->advance_x * sx);
+    }
 
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        glDepthFunc(GL_ALWAYS);
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, 24 * sizeof(float), data);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (vertices.empty())
+        return;
 
-        glUseProgram(textprogram_id);
-        glBindVertexArray(textVAO);
+    size_t offset = textstream->write(vertices.data(), vertices.size() * sizeof(TextVertex));
 
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        glBindVertexArray(0);
-        glUseProgram(0);
-        glDepthFunc(GL_LESS);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDepthFunc(GL_ALWAYS);
 
-        glDisable(GL_BLEND);
+    glUseProgram(textprogram_id);
+    glBindVertexArray(textVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, textstream->id());
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (void*)offset);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        x += (glyph->advance_x * sx);
-    }
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.size());
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+    glDepthFunc(GL_LESS);
+
+    glDisable(GL_BLEND);
 }
 
 float TextRendering_LineHeight(GLFWwindow* window)